@@ -0,0 +1,448 @@
+//==================================================================================================
+// Name        : amg.cpp
+// Author      :
+// Version     : 1.0
+// Copyright   : See the copyright notice in the README file.
+// Description : This file contains the setup and the V-cycle of the smoothed aggregation AMG
+//               preconditioner.
+//==================================================================================================
+
+#include "amg.h"
+
+//==================================================================================================
+// amgPreconditioner
+//==================================================================================================
+amgPreconditioner::amgPreconditioner()
+{
+    nLevels = 0;
+    nCoarse = 0;
+    chol = NULL;
+    for(int l=0; l<amgMaxLevels; l++)
+    {
+        A[l] = NULL;
+        P[l] = NULL;
+        R[l] = NULL;
+        diag[l] = NULL;
+        x[l] = NULL;
+        b[l] = NULL;
+        r[l] = NULL;
+    }
+}
+
+//==================================================================================================
+// void amgPreconditioner::clear()
+// Deletes the hierarchy. The finest operator belongs to the caller and is not deleted.
+//==================================================================================================
+void amgPreconditioner::clear()
+{
+    for(int l=0; l<nLevels; l++)
+    {
+        if(l > 0)
+            delete A[l];
+        delete P[l];
+        delete R[l];
+        delete[] diag[l];
+        delete[] x[l];
+        delete[] b[l];
+        delete[] r[l];
+        A[l] = NULL;
+        P[l] = NULL;
+        R[l] = NULL;
+        diag[l] = NULL;
+        x[l] = NULL;
+        b[l] = NULL;
+        r[l] = NULL;
+    }
+    delete[] chol;
+    chol = NULL;
+    nLevels = 0;
+
+    return;
+}
+
+//==================================================================================================
+// void amgPreconditioner::setup()
+//==================================================================================================
+/* Hierarchy construction :
+ * 1- The nodes of the current level are aggregated.
+ * 2- The smoothed prolongator P and the restriction R = P^T are built.
+ * 3- The coarse operator is A_c = R*A*P.
+ * 4- This is repeated until the operator is small enough to be factorized, or the coarsening
+ *    stagnates. The coarsest operator is factorized with a dense Cholesky decomposition.
+ */
+//==================================================================================================
+void amgPreconditioner::setup(csrMatrix* argA)
+{
+    clear();
+
+    A[0] = argA;
+    nLevels = 1;
+    int* agg;
+    int nAgg;
+
+    while(nLevels < amgMaxLevels && A[nLevels-1]->getNRows() > amgCoarseSize)
+    {
+        int l = nLevels-1;
+        int n = A[l]->getNRows();
+
+        agg = new int [n];
+        nAgg = aggregate(A[l], agg);
+        if(nAgg == 0 || nAgg > 0.9*n)
+        {
+            delete[] agg;
+            break;
+        }
+
+        P[l] = smoothedProlongator(A[l], agg, nAgg);
+        R[l] = P[l]->transpose();
+
+        csrMatrix* AP = A[l]->multiplyMatrix(P[l]);
+        A[l+1] = R[l]->multiplyMatrix(AP);
+        delete AP;
+        delete[] agg;
+
+        nLevels++;
+    }
+
+    ///Work vectors and diagonal positions on each level, the smoother divides by the diagonal
+    double nnzSum = 0.0;
+    for(int l=0; l<nLevels; l++)
+    {
+        int n = A[l]->getNRows();
+        diag[l] = new int [n];
+        for(int i=0; i<n; i++)
+        {
+            diag[l][i] = A[l]->findEntry(i,i);
+            if(diag[l][i] < 0 || A[l]->getVal()[diag[l][i]] == 0.0)
+            {
+                cout << "AMG: row " << i << " of level " << l << " has no diagonal! Aborting..." << endl;
+                exit(0);
+            }
+        }
+        x[l] = new double [n];
+        b[l] = new double [n];
+        r[l] = new double [n];
+        nnzSum += A[l]->getNnz();
+    }
+
+    factorizeCoarse();
+
+    cout << "> AMG hierarchy with " << nLevels << " levels, rows per level:";
+    for(int l=0; l<nLevels; l++)
+        cout << " " << A[l]->getNRows();
+    cout << endl << "> AMG operator complexity: " << nnzSum/A[0]->getNnz() << endl;
+
+    return;
+}
+
+//==================================================================================================
+// int amgPreconditioner::aggregate()
+//==================================================================================================
+/* Aggregation procedure :
+ * Node j is strongly connected to node i if |a_ij| >= amgStrength*sqrt(|a_ii*a_jj|). Rows without
+ * off-diagonal entries (e.g. the identity rows of Dirichlet nodes) are not aggregated, they are
+ * solved exactly by the smoother.
+ * 1- A node whose strong neighbours are all free forms a new aggregate with them.
+ * 2- Remaining nodes join the aggregate of phase 1 they are most strongly connected to.
+ * 3- Nodes that are still left form aggregates with their free strong neighbours.
+ * Returns the number of aggregates, agg[i] is the aggregate of node i (or -1).
+ */
+//==================================================================================================
+int amgPreconditioner::aggregate(csrMatrix* M, int* agg)
+{
+    int n = M->getNRows();
+    int* rowPtr = M->getRowPtr();
+    int* col = M->getCol();
+    double* val = M->getVal();
+
+    double* d = new double [n];
+    bool* isolated = new bool [n];
+    for(int i=0; i<n; i++)
+    {
+        d[i] = 0.0;
+        isolated[i] = true;
+        for(int k=rowPtr[i]; k<rowPtr[i+1]; k++)
+        {
+            if(col[k] == i)
+                d[i] = fabs(val[k]);
+            else if(val[k] != 0.0)
+                isolated[i] = false;
+        }
+        agg[i] = -1;
+    }
+
+    #define STRONG(i,k) (col[k]!=(i) && fabs(val[k]) >= amgStrength*sqrt(d[i]*d[col[k]]))
+
+    int nAgg = 0;
+    bool free;
+
+    ///Phase 1: root nodes with free neighbourhoods
+    for(int i=0; i<n; i++)
+    {
+        if(isolated[i] || agg[i] != -1)
+            continue;
+        free = true;
+        for(int k=rowPtr[i]; k<rowPtr[i+1]; k++)
+            if(STRONG(i,k) && agg[col[k]] != -1)
+                free = false;
+        if(!free)
+            continue;
+
+        agg[i] = nAgg;
+        for(int k=rowPtr[i]; k<rowPtr[i+1]; k++)
+            if(STRONG(i,k))
+                agg[col[k]] = nAgg;
+        nAgg++;
+    }
+
+    ///Phase 2: attach the remaining nodes to the most strongly connected aggregate of phase 1
+    int* phase1 = new int [n];
+    std::memcpy(phase1, agg, n*sizeof(int));
+    for(int i=0; i<n; i++)
+    {
+        if(isolated[i] || agg[i] != -1)
+            continue;
+        double strongest = 0.0;
+        for(int k=rowPtr[i]; k<rowPtr[i+1]; k++)
+        {
+            if(STRONG(i,k) && phase1[col[k]] != -1 && fabs(val[k]) > strongest)
+            {
+                strongest = fabs(val[k]);
+                agg[i] = phase1[col[k]];
+            }
+        }
+    }
+
+    ///Phase 3: new aggregates from what is left
+    for(int i=0; i<n; i++)
+    {
+        if(isolated[i] || agg[i] != -1)
+            continue;
+        agg[i] = nAgg;
+        for(int k=rowPtr[i]; k<rowPtr[i+1]; k++)
+            if(STRONG(i,k) && agg[col[k]] == -1 && !isolated[col[k]])
+                agg[col[k]] = nAgg;
+        nAgg++;
+    }
+
+    #undef STRONG
+
+    delete[] d;
+    delete[] isolated;
+    delete[] phase1;
+    return nAgg;
+}
+
+//==================================================================================================
+// csrMatrix* amgPreconditioner::smoothedProlongator()
+//==================================================================================================
+/* P = (I - omega*D^{-1}*A)*P_t, where P_t has a single 1 per row in the column of the aggregate of
+ * the node. omega = 4/(3*rho) with the Gershgorin estimate rho >= spectral radius of D^{-1}*A.
+ * The returned matrix is n x nAgg.
+ */
+//==================================================================================================
+csrMatrix* amgPreconditioner::smoothedProlongator(csrMatrix* M, int* agg, int nAgg)
+{
+    int n = M->getNRows();
+    int* rowPtr = M->getRowPtr();
+    int* col = M->getCol();
+    double* val = M->getVal();
+
+    ///Tentative prolongator
+    int* tRowPtr = new int [n+1];
+    int* tCol = new int [n];
+    double* tVal = new double [n];
+    tRowPtr[0] = 0;
+    for(int i=0; i<n; i++)
+    {
+        tRowPtr[i+1] = tRowPtr[i];
+        if(agg[i] != -1)
+        {
+            tCol[tRowPtr[i+1]] = agg[i];
+            tVal[tRowPtr[i+1]++] = 1.0;
+        }
+    }
+    csrMatrix* Pt = new csrMatrix;
+    Pt->setData(n, nAgg, tRowPtr, tCol, tVal);
+
+    ///Spectral radius estimate and inverse diagonal
+    double* invD = new double [n];
+    double rho = 0.0;
+    for(int i=0; i<n; i++)
+    {
+        double rowSum = 0.0;
+        invD[i] = 0.0;
+        for(int k=rowPtr[i]; k<rowPtr[i+1]; k++)
+        {
+            rowSum += fabs(val[k]);
+            if(col[k] == i)
+                invD[i] = 1.0/val[k];
+        }
+        if(rowSum*fabs(invD[i]) > rho)
+            rho = rowSum*fabs(invD[i]);
+    }
+    double omega = 4.0/(3.0*rho);
+
+    ///P = P_t - omega*D^{-1}*A*P_t. A*P_t contains the pattern of P_t for every aggregated node.
+    csrMatrix* S = M->multiplyMatrix(Pt);
+    int* sRowPtr = S->getRowPtr();
+    int* sCol = S->getCol();
+    double* sVal = S->getVal();
+    for(int i=0; i<n; i++)
+    {
+        for(int k=sRowPtr[i]; k<sRowPtr[i+1]; k++)
+        {
+            sVal[k] = -omega*invD[i]*sVal[k];
+            if(sCol[k] == agg[i])
+                sVal[k] += 1.0;
+        }
+    }
+
+    delete Pt;
+    delete[] invD;
+    return S;
+}
+
+//==================================================================================================
+// void amgPreconditioner::factorizeCoarse() / solveCoarse()
+// Dense Cholesky factorization and solve on the coarsest level. A pivot that is not positive
+// (singular coarse operator) is replaced by one and its column is dropped.
+//==================================================================================================
+void amgPreconditioner::factorizeCoarse()
+{
+    csrMatrix* Ac = A[nLevels-1];
+    nCoarse = Ac->getNRows();
+    chol = new double [nCoarse*nCoarse]();
+
+    for(int i=0; i<nCoarse; i++)
+        for(int k=Ac->getRowPtr()[i]; k<Ac->getRowPtr()[i+1]; k++)
+            chol[i*nCoarse + Ac->getCol()[k]] = Ac->getVal()[k];
+
+    for(int j=0; j<nCoarse; j++)
+    {
+        double d = chol[j*nCoarse+j];
+        for(int k=0; k<j; k++)
+            d -= chol[j*nCoarse+k]*chol[j*nCoarse+k];
+        if(d <= 0.0)
+        {
+            chol[j*nCoarse+j] = 1.0;
+            for(int i=j+1; i<nCoarse; i++)
+                chol[i*nCoarse+j] = 0.0;
+            continue;
+        }
+        d = sqrt(d);
+        chol[j*nCoarse+j] = d;
+        for(int i=j+1; i<nCoarse; i++)
+        {
+            double s = chol[i*nCoarse+j];
+            for(int k=0; k<j; k++)
+                s -= chol[i*nCoarse+k]*chol[j*nCoarse+k];
+            chol[i*nCoarse+j] = s/d;
+        }
+    }
+
+    return;
+}
+
+void amgPreconditioner::solveCoarse(const double* rhs, double* sol)
+{
+    for(int i=0; i<nCoarse; i++)
+    {
+        double s = rhs[i];
+        for(int k=0; k<i; k++)
+            s -= chol[i*nCoarse+k]*sol[k];
+        sol[i] = s/chol[i*nCoarse+i];
+    }
+    for(int i=nCoarse-1; i>=0; i--)
+    {
+        double s = sol[i];
+        for(int k=i+1; k<nCoarse; k++)
+            s -= chol[k*nCoarse+i]*sol[k];
+        sol[i] = s/chol[i*nCoarse+i];
+    }
+
+    return;
+}
+
+//==================================================================================================
+// void amgPreconditioner::gaussSeidel()
+// One Gauss-Seidel sweep on level l, in forward or backward order.
+//==================================================================================================
+void amgPreconditioner::gaussSeidel(int l, bool forward)
+{
+    int n = A[l]->getNRows();
+    int* rowPtr = A[l]->getRowPtr();
+    int* col = A[l]->getCol();
+    double* val = A[l]->getVal();
+
+    for(int j=0; j<n; j++)
+    {
+        int i = forward ? j : n-1-j;
+        double s = b[l][i];
+        for(int k=rowPtr[i]; k<rowPtr[i+1]; k++)
+            if(k != diag[l][i])
+                s -= val[k]*x[l][col[k]];
+        x[l][i] = s/val[diag[l][i]];
+    }
+
+    return;
+}
+
+//==================================================================================================
+// void amgPreconditioner::vCycle()
+// Solves A[l]*x[l] = b[l] approximately, starting from x[l] = 0.
+//==================================================================================================
+void amgPreconditioner::vCycle(int l)
+{
+    if(l == nLevels-1)
+    {
+        solveCoarse(b[l], x[l]);
+        return;
+    }
+
+    int n = A[l]->getNRows();
+    int nc = A[l+1]->getNRows();
+
+    ///Pre-smoothing
+    for(int s=0; s<amgSweeps; s++)
+        gaussSeidel(l, true);
+
+    ///Restrict the residual and solve the coarse problem
+    A[l]->multiply(x[l], r[l]);
+    for(int i=0; i<n; i++)
+        r[l][i] = b[l][i] - r[l][i];
+    R[l]->multiply(r[l], b[l+1]);
+    for(int i=0; i<nc; i++)
+        x[l+1][i] = 0.0;
+    vCycle(l+1);
+
+    ///Coarse grid correction
+    P[l]->multiply(x[l+1], r[l]);
+    for(int i=0; i<n; i++)
+        x[l][i] += r[l][i];
+
+    ///Post-smoothing
+    for(int s=0; s<amgSweeps; s++)
+        gaussSeidel(l, false);
+
+    return;
+}
+
+//==================================================================================================
+// void amgPreconditioner::apply()
+// z = one V-cycle applied to r.
+//==================================================================================================
+void amgPreconditioner::apply(const double* rIn, double* z)
+{
+    int n = A[0]->getNRows();
+
+    for(int i=0; i<n; i++)
+    {
+        b[0][i] = rIn[i];
+        x[0][i] = 0.0;
+    }
+    vCycle(0);
+    std::memcpy(z, x[0], n*sizeof(double));
+
+    return;
+}
@@ -0,0 +1,69 @@
+//==================================================================================================
+// Name        : amg.h
+// Author      :
+// Version     : 1.0
+// Copyright   : See the copyright notice in the README file.
+// Description : Smoothed aggregation algebraic multigrid preconditioner.
+//==================================================================================================
+
+#ifndef AMG_H_
+#define AMG_H_
+
+#include "linearSolver.h"
+
+const int    amgMaxLevels  = 20;    /// Maximum number of multigrid levels
+const int    amgCoarseSize = 200;   /// Rows below which the coarse system is solved directly
+const double amgStrength   = 0.08;  /// Strength of connection threshold for the aggregation
+const int    amgSweeps     = 1;     /// Gauss-Seidel sweeps before and after the coarse correction
+
+/*!
+ * \brief This class defines the SMOOTHED AGGREGATION AMG PRECONDITIONER.
+ *
+ * The hierarchy is built once from the assembled operator in setup():
+ * - nodes are grouped into aggregates of strongly connected neighbours,
+ * - the tentative prolongator P_t injects a constant on each aggregate,
+ * - it is smoothed by one damped Jacobi step, P = (I - omega*D^{-1}*A)*P_t,
+ * - the coarse operator is the Galerkin product A_c = P^T*A*P.
+ * apply() performs one V-cycle with symmetric Gauss-Seidel smoothing (forward before, backward
+ * after the coarse correction) and a dense Cholesky solve on the coarsest level, so it is a
+ * symmetric preconditioner for CG.
+ */
+class amgPreconditioner : public preconditioner
+{
+    private:
+        /// PRIVATE VARIABLES
+        int         nLevels;                // number of levels
+        csrMatrix*  A[amgMaxLevels];        // operator on each level (A[0] is not owned)
+        csrMatrix*  P[amgMaxLevels];        // prolongation from level l+1 to level l
+        csrMatrix*  R[amgMaxLevels];        // restriction from level l to level l+1 (P^T)
+        int*        diag[amgMaxLevels];     // position of the diagonal entry of each row
+        double*     x[amgMaxLevels];        // solution on each level
+        double*     b[amgMaxLevels];        // right hand side on each level
+        double*     r[amgMaxLevels];        // residual on each level
+        double*     chol;                   // dense Cholesky factor of the coarsest operator
+        int         nCoarse;                // size of the coarsest level
+
+        /// PRIVATE METHODS
+        void clear();
+        int  aggregate(csrMatrix*, int*);
+        csrMatrix* smoothedProlongator(csrMatrix*, int*, int);
+        void factorizeCoarse();
+        void solveCoarse(const double*, double*);
+        void gaussSeidel(int, bool);
+        void vCycle(int);
+
+    protected:
+
+    public:
+        /// DEFAULT CONSTRUCTOR
+        amgPreconditioner();
+
+        /// DESTRUCTOR
+        ~amgPreconditioner(){clear();};
+
+        /// PUBLIC INTERFACE METHODS
+        void setup(csrMatrix*);
+        void apply(const double*, double*);
+};
+
+#endif /* AMG_H_ */
@@ -0,0 +1,150 @@
+//==================================================================================================
+// Name        : asyncWriter.cpp
+// Author      :
+// Version     : 1.0
+// Copyright   : See the copyright notice in the README file.
+// Description : This file contains the output thread and the snapshot buffers of asyncWriter.
+//==================================================================================================
+
+#include "asyncWriter.h"
+
+//==================================================================================================
+// void asyncWriter::start()
+// Allocates nBuffers snapshots of the mesh and starts the writer thread.
+//==================================================================================================
+void asyncWriter::start(inputSettings* argSettings, triMesh* argMesh, int argNBuffers)
+{
+    settings = argSettings;
+    mesh = argMesh;
+    nBuffers = argNBuffers;
+    nn = mesh->getNn();
+
+    postP = new postProcessor;
+    buffer = new double* [nBuffers];
+    for(int i=0; i<nBuffers; i++)
+        buffer[i] = new double [nn];
+    bufTs = new int [nBuffers];
+    bufTime = new double [nBuffers];
+    bufTitle = new string [nBuffers];
+
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&notEmpty, NULL);
+    pthread_cond_init(&notFull, NULL);
+    if(pthread_create(&thread, NULL, asyncWriter::run, this) != 0)
+    {
+        cout << "Unable to start the output thread! Aborting..." << endl;
+        exit(0);
+    }
+
+    cout << "> Asynchronous output with " << nBuffers << " snapshot buffers ("
+         << nBuffers*nn*sizeof(double)/1.0e6 << " MB)" << endl;
+    return;
+}
+
+//==================================================================================================
+// void asyncWriter::push()
+//==================================================================================================
+/* Hands the field T of time step ts to the writer thread :
+ * 1- the next buffer in order is taken, if all buffers are waiting to be written the call blocks
+ *    until the writer has written the oldest one,
+ * 2- T and the current title are copied into it outside of the lock, the writer does not touch
+ *    a buffer before it is published,
+ * 3- the snapshot is published and the writer is woken up.
+ * Only one thread may push at a time.
+ */
+//==================================================================================================
+void asyncWriter::push(int ts, double time, const double* T)
+{
+    pthread_mutex_lock(&lock);
+    if(count == nBuffers)
+    {
+        double waitStart = wallTime();
+        while(count == nBuffers)
+            pthread_cond_wait(&notFull, &lock);
+        waitTime += wallTime() - waitStart;
+    }
+    int slot = (head + count)%nBuffers;
+    pthread_mutex_unlock(&lock);
+
+    std::memcpy(buffer[slot], T, nn*sizeof(double));
+    bufTs[slot] = ts;
+    bufTime[slot] = time;
+    bufTitle[slot] = settings->getTitle();
+
+    pthread_mutex_lock(&lock);
+    count++;
+    pthread_cond_signal(&notEmpty);
+    pthread_mutex_unlock(&lock);
+
+    return;
+}
+
+//==================================================================================================
+// void asyncWriter::finish()
+// Waits until all snapshots are written, stops the writer thread and reports the timing.
+//==================================================================================================
+void asyncWriter::finish()
+{
+    pthread_mutex_lock(&lock);
+    done = true;
+    pthread_cond_signal(&notEmpty);
+    pthread_mutex_unlock(&lock);
+
+    double joinStart = wallTime();
+    pthread_join(thread, NULL);
+    waitTime += wallTime() - joinStart;
+
+    pthread_cond_destroy(&notFull);
+    pthread_cond_destroy(&notEmpty);
+    pthread_mutex_destroy(&lock);
+
+    cout << "> Asynchronous output: " << nWritten << " files written in " << writeTime
+         << " s by the output thread, the solver waited " << waitTime << " s" << endl;
+    return;
+}
+
+//==================================================================================================
+// void* asyncWriter::run()
+// Entry point of the writer thread.
+//==================================================================================================
+void* asyncWriter::run(void* arg)
+{
+    ((asyncWriter*)arg)->writeLoop();
+
+    return NULL;
+}
+
+//==================================================================================================
+// void asyncWriter::writeLoop()
+// Writes the snapshots in the order they were pushed until finish() is called and all are written.
+//==================================================================================================
+void asyncWriter::writeLoop()
+{
+    while(true)
+    {
+        pthread_mutex_lock(&lock);
+        while(count == 0 && !done)
+            pthread_cond_wait(&notEmpty, &lock);
+        if(count == 0 && done)
+        {
+            pthread_mutex_unlock(&lock);
+            break;
+        }
+        int slot = head;
+        pthread_mutex_unlock(&lock);
+
+        double writeStart = wallTime();
+        postP->postProcessorControl(settings, mesh, bufTs[slot], bufTime[slot], buffer[slot],
+                                    bufTitle[slot]);
+        writeTime += wallTime() - writeStart;
+        nWritten++;
+
+        pthread_mutex_lock(&lock);
+        head = (head + 1)%nBuffers;
+        count--;
+        pthread_cond_signal(&notFull);
+        pthread_mutex_unlock(&lock);
+    }
+
+    return;
+}
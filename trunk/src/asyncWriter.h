@@ -0,0 +1,84 @@
+//==================================================================================================
+// Name        : asyncWriter.h
+// Author      :
+// Version     : 1.0
+// Copyright   : See the copyright notice in the README file.
+// Description : Output thread which writes the solution files in the background of the time loop.
+//==================================================================================================
+
+#ifndef ASYNCWRITER_H_
+#define ASYNCWRITER_H_
+
+#include <pthread.h>
+
+#include "postProcessor.h"
+
+/*!
+ * \brief This class defines an ASYNCHRONOUS OUTPUT WRITER.
+ *
+ * The time loop hands a temperature field to push(), which copies it into one of nBuffers
+ * preallocated snapshot buffers and returns. A writer thread takes the snapshots in the order
+ * they were pushed and writes them with its own postProcessor, so the time loop does not wait
+ * for the output. If all buffers are still waiting to be written, push() blocks until the writer
+ * has freed one (back-pressure), so at most nBuffers fields are held in memory.
+ * The writer reads only the snapshot and the mesh geometry and numbering, which do not change
+ * during the time loop.
+ */
+class asyncWriter
+{
+    private:
+        /// PRIVATE VARIABLES
+        inputSettings*  settings;   // a local pointer for the settings
+        triMesh*        mesh;       // a local pointer for the mesh
+        postProcessor*  postP;      // post processor used by the writer thread
+        int             nBuffers;   // number of snapshot buffers
+        int             nn;         // number of nodes of a snapshot
+        double**        buffer;     // temperature field of each snapshot
+        int*            bufTs;      // time step of each snapshot
+        double*         bufTime;    // time of each snapshot
+        string*         bufTitle;   // title of the output files of each snapshot
+        int             head;       // oldest snapshot that is not written yet
+        int             count;      // number of snapshots waiting to be written
+        bool            done;       // no more snapshots will be pushed
+        pthread_t       thread;     // writer thread
+        pthread_mutex_t lock;       // protects head, count and done
+        pthread_cond_t  notEmpty;   // signalled when a snapshot is pushed or done is set
+        pthread_cond_t  notFull;    // signalled when a snapshot is written
+        int             nWritten;   // number of snapshots written
+        double          waitTime;   // time the time loop waited for a free buffer
+        double          writeTime;  // time the writer thread spent writing
+
+        /// PRIVATE METHODS
+        static void* run(void*);
+        void writeLoop();
+
+    protected:
+
+    public:
+        /// DEFAULT CONSTRUCTOR
+        asyncWriter()
+        {
+            postP = NULL; nBuffers = 0; nn = 0; buffer = NULL; bufTs = NULL; bufTime = NULL;
+            bufTitle = NULL; head = 0; count = 0; done = false;
+            nWritten = 0; waitTime = 0.0; writeTime = 0.0;
+        };
+
+        /// DESTRUCTOR
+        ~asyncWriter()
+        {
+            for(int i=0; i<nBuffers; i++)
+                delete[] buffer[i];
+            delete[] buffer;
+            delete[] bufTs;
+            delete[] bufTime;
+            delete[] bufTitle;
+            delete postP;
+        };
+
+        /// PUBLIC INTERFACE METHODS
+        void start(inputSettings*, triMesh*, int);
+        void push(int, double, const double*);
+        void finish();
+};
+
+#endif /* ASYNCWRITER_H_ */
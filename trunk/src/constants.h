@@ -18,6 +18,9 @@
 #include <cstring>
 #include <limits>
 #include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 
@@ -29,7 +32,23 @@ const int nsd = 2;  /// number of space dimensions
 const int nen = 3;  /// number of element nodes
 const int nef = 3;  /// number of element faces
 
+const int ltsMaxLevels = 16;    /// maximum number of local time step levels
+
 ///Mapping from the edge numbers to node numbers.
 const int edgeNodes[3][2] = {{0,1},{1,2},{2,0}};
 
+const int setupBatch = 8;   /// number of elements processed together in the setup (SIMD width)
+const int sellC = 8;        /// rows per chunk of the SELL-C-sigma matrix format (SIMD width)
+const int outputBlock = 65536;  /// bytes written per call by the built-in output writers
+
+/// Wall clock time in seconds
+inline double wallTime()
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return (double)clock()/CLOCKS_PER_SEC;
+#endif
+}
+
 #endif /* CONSTANTS_H_ */
@@ -0,0 +1,251 @@
+//==================================================================================================
+// Name        : elementKernel.h
+// Author      :
+// Version     : 1.0
+// Copyright   : See the copyright notice in the README file.
+// Description : Element kernels which compute the element stiffness matrix, the lumped mass and
+//               the source vector from the node coordinates. Element type and integration rule are
+//               template parameters, so all loops have compile-time bounds.
+//==================================================================================================
+
+#ifndef ELEMENTKERNEL_H_
+#define ELEMENTKERNEL_H_
+
+#include "constants.h"
+
+/*!
+ * \brief This class defines the LINEAR TRIANGLE (P1) element type.
+ *
+ * Shape functions and their derivatives on the reference triangle, in the same node order as
+ * triMasterElement.
+ */
+struct triP1
+{
+    static const int nNodes = 3;
+
+    static void shape(double ksi, double eta, double* S, double* dSdKsi, double* dSdEta)
+    {
+        S[0] = 1.0-ksi-eta;     dSdKsi[0] = -1.0;   dSdEta[0] = -1.0;
+        S[1] = ksi;             dSdKsi[1] =  1.0;   dSdEta[1] =  0.0;
+        S[2] = eta;             dSdKsi[2] =  0.0;   dSdEta[2] =  1.0;
+    };
+};
+
+
+/*!
+ * \brief This class defines the 7 POINT GAUSS QUADRATURE RULE on the reference triangle.
+ *
+ * Points and weights are those of triMasterElement::setupGaussQuadrature().
+ */
+struct triGauss7
+{
+    static const int nPoints = 7;
+
+    static double ksi(int g)
+    {
+        static const double p[7] = {0.333333333333333, 0.059715871789770, 0.470142064105115,
+                                    0.470142064105115, 0.101286507323456, 0.101286507323456,
+                                    0.797426985353087};
+        return p[g];
+    };
+    static double eta(int g)
+    {
+        static const double p[7] = {0.333333333333333, 0.470142064105115, 0.059715871789770,
+                                    0.470142064105115, 0.797426985353087, 0.101286507323456,
+                                    0.101286507323456};
+        return p[g];
+    };
+    static double weight(int g)
+    {
+        static const double w[7] = {0.225/2.0, 0.132394152788/2.0, 0.132394152788/2.0,
+                                    0.132394152788/2.0, 0.125939180544/2.0, 0.125939180544/2.0,
+                                    0.125939180544/2.0};
+        return w[g];
+    };
+};
+
+
+/*!
+ * \brief This class selects EXACT INTEGRATION in closed form.
+ */
+struct exactRule
+{
+};
+
+
+/*!
+ * \brief This class defines the ELEMENT KERNEL for an element type and an integration rule.
+ *
+ * compute() returns for one element with node coordinates X, Y
+ * - the stiffness matrix K (row-wise, nNodes x nNodes) of the diffusion coefficient k,
+ * - the lumped mass M_l (diagonal of the consistent mass scaled by sum of all / sum of diagonal
+ *   entries),
+ * - the source vector F of the source term, which acts only on nodes with Y >= 0.0004.
+ * The general version integrates numerically with the quadrature rule. The Jacobian is evaluated
+ * at every point, so it also holds for element types with non-constant gradients.
+ */
+template<class Element, class Rule>
+struct elementKernel
+{
+    static void compute(const double* X, const double* Y, double k, double source,
+                        double* K, double* M_l, double* F)
+    {
+        const int n = Element::nNodes;
+        double M[n*n], S[n], dSdKsi[n], dSdEta[n], dSdX[n], dSdY[n];
+
+        for(int i=0; i<n*n; i++)
+        {
+            K[i] = 0.0;
+            M[i] = 0.0;
+        }
+        for(int i=0; i<n; i++)
+            F[i] = 0.0;
+
+        for(int g=0; g<Rule::nPoints; g++)
+        {
+            Element::shape(Rule::ksi(g), Rule::eta(g), S, dSdKsi, dSdEta);
+
+            ///Jacobian, its inverse and the derivatives of the shape functions in x and y
+            double J[4] = {0.0, 0.0, 0.0, 0.0};
+            for(int i=0; i<n; i++)
+            {
+                J[0] += dSdKsi[i]*X[i];
+                J[1] += dSdKsi[i]*Y[i];
+                J[2] += dSdEta[i]*X[i];
+                J[3] += dSdEta[i]*Y[i];
+            }
+            double det_J = J[0]*J[3] - J[1]*J[2];
+            double wdJ = Rule::weight(g)*fabs(det_J);
+            for(int i=0; i<n; i++)
+            {
+                dSdX[i] = ( J[3]*dSdKsi[i] - J[1]*dSdEta[i])/det_J;
+                dSdY[i] = (-J[2]*dSdKsi[i] + J[0]*dSdEta[i])/det_J;
+            }
+
+            for(int i=0; i<n; i++)
+            {
+                for(int j=0; j<n; j++)
+                {
+                    K[n*i+j] += k*(dSdX[i]*dSdX[j] + dSdY[i]*dSdY[j])*wdJ;
+                    M[n*i+j] += S[i]*S[j]*wdJ;
+                }
+                if(Y[i]>=0.0004)
+                    F[i] += S[i]*source*wdJ;
+            }
+        }
+
+        ///Lumping of the mass matrix
+        double sum_all = 0.0, sum_diag = 0.0;
+        for(int i=0; i<n*n; i++)
+            sum_all += M[i];
+        for(int i=0; i<n; i++)
+            sum_diag += M[n*i+i];
+        for(int i=0; i<n; i++)
+            M_l[i] = M[n*i+i]*sum_all/sum_diag;
+    };
+
+    /// Batch of W elements, the arrays are indexed [entry][element of the batch]
+    template<int W>
+    static void computeBatch(const double (*X)[W], const double (*Y)[W], double k, double source,
+                             double (*K)[W], double (*M_l)[W], double (*F)[W])
+    {
+        const int n = Element::nNodes;
+        double Xe[n], Ye[n], Ke[n*n], Me[n], Fe[n];
+
+        for(int b=0; b<W; b++)
+        {
+            for(int i=0; i<n; i++)
+            {
+                Xe[i] = X[i][b];
+                Ye[i] = Y[i][b];
+            }
+            compute(Xe, Ye, k, source, Ke, Me, Fe);
+            for(int i=0; i<n*n; i++)
+                K[i][b] = Ke[i];
+            for(int i=0; i<n; i++)
+            {
+                M_l[i][b] = Me[i];
+                F[i][b] = Fe[i];
+            }
+        }
+    };
+};
+
+
+/*!
+ * \brief EXACT P1 KERNEL.
+ *
+ * The gradients of linear shape functions are constant, with b_i = Y_j - Y_k, c_i = X_k - X_j
+ * (i,j,k cyclic) and the area A = |det J|/2 :
+ *		K_ij = k*(b_i*b_j + c_i*c_j)/(4*A),	M_l,i = A/3,	F_i = source*A/3
+ * No quadrature loop and no division per entry is needed.
+ */
+template<>
+struct elementKernel<triP1, exactRule>
+{
+    static void compute(const double* X, const double* Y, double k, double source,
+                        double* K, double* M_l, double* F)
+    {
+        double b[3] = {Y[1]-Y[2], Y[2]-Y[0], Y[0]-Y[1]};
+        double c[3] = {X[2]-X[1], X[0]-X[2], X[1]-X[0]};
+        double A = 0.5*fabs(c[2]*b[1] - c[1]*b[2]);
+        double kA = k/(4.0*A);
+
+        for(int i=0; i<3; i++)
+        {
+            for(int j=0; j<3; j++)
+                K[3*i+j] = kA*(b[i]*b[j] + c[i]*c[j]);
+            M_l[i] = A/3.0;
+            F[i] = (Y[i]>=0.0004 ? source*A/3.0 : 0.0);
+        }
+    };
+
+    /// Stiffness action KT = K*T of one element without forming K : with the gradient
+    /// (gx, gy) = (sum b_j*T_j, sum c_j*T_j) the product is KT_i = k*(b_i*gx + c_i*gy)/(4*A).
+    static void applyK(const double* X, const double* Y, double k, const double* T, double* KT)
+    {
+        double b[3] = {Y[1]-Y[2], Y[2]-Y[0], Y[0]-Y[1]};
+        double c[3] = {X[2]-X[1], X[0]-X[2], X[1]-X[0]};
+        double kA = k/(2.0*fabs(c[2]*b[1] - c[1]*b[2]));
+        double gx = kA*(b[0]*T[0] + b[1]*T[1] + b[2]*T[2]);
+        double gy = kA*(c[0]*T[0] + c[1]*T[1] + c[2]*T[2]);
+
+        for(int i=0; i<3; i++)
+            KT[i] = b[i]*gx + c[i]*gy;
+    };
+
+    /// Batch of W elements, the arrays are indexed [entry][element of the batch]. The loop over the
+    /// batch has no branches and unit stride, so it is vectorized.
+    template<int W>
+    static void computeBatch(const double (*X)[W], const double (*Y)[W], double k, double source,
+                             double (*K)[W], double (*M_l)[W], double (*F)[W])
+    {
+        #pragma omp simd
+        for(int b=0; b<W; b++)
+        {
+            double b0 = Y[1][b]-Y[2][b], b1 = Y[2][b]-Y[0][b], b2 = Y[0][b]-Y[1][b];
+            double c0 = X[2][b]-X[1][b], c1 = X[0][b]-X[2][b], c2 = X[1][b]-X[0][b];
+            double A = 0.5*fabs(c2*b1 - c1*b2);
+            double kA = k/(4.0*A);
+
+            K[0][b] = kA*(b0*b0 + c0*c0);
+            K[1][b] = kA*(b0*b1 + c0*c1);
+            K[2][b] = kA*(b0*b2 + c0*c2);
+            K[3][b] = K[1][b];
+            K[4][b] = kA*(b1*b1 + c1*c1);
+            K[5][b] = kA*(b1*b2 + c1*c2);
+            K[6][b] = K[2][b];
+            K[7][b] = K[5][b];
+            K[8][b] = kA*(b2*b2 + c2*c2);
+
+            M_l[0][b] = A/3.0;
+            M_l[1][b] = A/3.0;
+            M_l[2][b] = A/3.0;
+            F[0][b] = (Y[0][b]>=0.0004 ? source*A/3.0 : 0.0);
+            F[1][b] = (Y[1][b]>=0.0004 ? source*A/3.0 : 0.0);
+            F[2][b] = (Y[2][b]>=0.0004 ? source*A/3.0 : 0.0);
+        }
+    };
+};
+
+#endif /* ELEMENTKERNEL_H_ */
@@ -0,0 +1,260 @@
+//==================================================================================================
+// Name        : linearSolver.cpp
+// Author      :
+// Version     : 1.0
+// Copyright   : See the copyright notice in the README file.
+// Description : This file contains the conjugate gradient solver and the preconditioners.
+//==================================================================================================
+
+#include "linearSolver.h"
+#include "amg.h"
+
+//==================================================================================================
+// preconditioner* createPreconditioner()
+//==================================================================================================
+preconditioner* createPreconditioner(string name)
+{
+    if(name == "jacobi")
+        return new jacobiPreconditioner;
+    else if(name == "ic0")
+        return new ic0Preconditioner;
+    else if(name == "amg")
+        return new amgPreconditioner;
+
+    cout << "Unknown preconditioner : " << name << "! Aborting..." << endl;
+    exit(0);
+}
+
+//==================================================================================================
+// void jacobiPreconditioner::setup() / apply()
+//==================================================================================================
+void jacobiPreconditioner::setup(csrMatrix* A)
+{
+    n = A->getNRows();
+    delete[] invDiag;
+    invDiag = new double [n];
+
+    for(int i=0; i<n; i++)
+        invDiag[i] = 1.0/A->getVal()[A->findEntry(i,i)];
+
+    return;
+}
+
+void jacobiPreconditioner::apply(const double* r, double* z)
+{
+    #pragma omp parallel for
+    for(int i=0; i<n; i++)
+        z[i] = invDiag[i]*r[i];
+
+    return;
+}
+
+//==================================================================================================
+// void ic0Preconditioner::setup()
+//==================================================================================================
+/* Factorization procedure (row by row, A = L*L^T on the pattern of A) :
+ * 1- For every entry (i,k) left of the diagonal:
+ *		L_ik = (A_ik - sum_j L_ij*L_kj) / L_kk,	j < k
+ *    The sum runs over the columns that rows i and k have in common. Both rows are sorted, so
+ *    they are merged.
+ * 2- The diagonal is L_ii = sqrt(A_ii - sum_j L_ij^2), j < i. If the argument is not positive
+ *    (possible for an incomplete factorization) the diagonal of A is used instead.
+ */
+//==================================================================================================
+void ic0Preconditioner::setup(csrMatrix* A)
+{
+    n = A->getNRows();
+    delete L;
+    delete[] diag;
+    L = new csrMatrix;
+    L->copyPattern(A);
+    diag = new int [n];
+
+    int* rowPtr = L->getRowPtr();
+    int* col = L->getCol();
+    double* val = L->getVal();
+    std::memcpy(val, A->getVal(), A->getNnz()*sizeof(double));
+
+    int nBreakdown = 0;
+    for(int i=0; i<n; i++)
+    {
+        diag[i] = L->findEntry(i,i);
+
+        for(int k=rowPtr[i]; k<diag[i]; k++)
+        {
+            int c = col[k];
+            double sum = val[k];
+
+            ///Merge row i (left of column c) and row c (left of its diagonal)
+            int a = rowPtr[i];
+            int b = rowPtr[c];
+            while(a<k && b<diag[c])
+            {
+                if(col[a] < col[b])
+                    a++;
+                else if(col[a] > col[b])
+                    b++;
+                else
+                    sum -= val[a++]*val[b++];
+            }
+            val[k] = sum/val[diag[c]];
+        }
+
+        double d = val[diag[i]];
+        for(int k=rowPtr[i]; k<diag[i]; k++)
+            d -= val[k]*val[k];
+        if(d <= 0.0)
+        {
+            d = fabs(A->getVal()[diag[i]]);
+            nBreakdown++;
+        }
+        val[diag[i]] = sqrt(d);
+    }
+
+    if(nBreakdown > 0)
+        cout << "> Warning! IC(0) breakdown in " << nBreakdown << " rows." << endl;
+
+    return;
+}
+
+//==================================================================================================
+// void ic0Preconditioner::apply()
+// z = (L*L^T)^{-1} r by a forward and a backward substitution.
+//==================================================================================================
+void ic0Preconditioner::apply(const double* r, double* z)
+{
+    int* rowPtr = L->getRowPtr();
+    int* col = L->getCol();
+    double* val = L->getVal();
+
+    ///Forward substitution L*y = r (y is stored in z)
+    for(int i=0; i<n; i++)
+    {
+        double sum = r[i];
+        for(int k=rowPtr[i]; k<diag[i]; k++)
+            sum -= val[k]*z[col[k]];
+        z[i] = sum/val[diag[i]];
+    }
+
+    ///Backward substitution L^T*z = y, column by column
+    for(int i=n-1; i>=0; i--)
+    {
+        z[i] = z[i]/val[diag[i]];
+        for(int k=rowPtr[i]; k<diag[i]; k++)
+            z[col[k]] -= val[k]*z[i];
+    }
+
+    return;
+}
+
+//==================================================================================================
+// void pcgSolver::setup()
+//==================================================================================================
+void pcgSolver::setup(csrMatrix* argA, preconditioner* argP, double argTol, int argMaxIter)
+{
+    A = argA;
+    P = argP;
+    tol = argTol;
+    maxIter = argMaxIter;
+
+    if(n != A->getNRows())
+    {
+        n = A->getNRows();
+        delete[] r;
+        delete[] z;
+        delete[] p;
+        delete[] q;
+        r = new double [n];
+        z = new double [n];
+        p = new double [n];
+        q = new double [n];
+    }
+
+    return;
+}
+
+//==================================================================================================
+// int pcgSolver::solve()
+//==================================================================================================
+/* Solves A*x = b. x holds the initial guess on entry and the solution on exit. The iteration stops
+ * when ||b - A*x|| / ||b|| < tol or after maxIter iterations. Returns the number of iterations.
+ */
+//==================================================================================================
+int pcgSolver::solve(const double* b, double* x)
+{
+    double bNorm = 0.0, rNorm = 0.0, rz = 0.0, rzOld, pq, alpha, beta;
+    int iter;
+
+    if(S != NULL)
+        S->multiply(x, q);
+    else
+        A->multiply(x, q);
+    #pragma omp parallel for reduction(+:bNorm,rNorm)
+    for(int i=0; i<n; i++)
+    {
+        r[i] = b[i] - q[i];
+        bNorm += b[i]*b[i];
+        rNorm += r[i]*r[i];
+    }
+    bNorm = sqrt(bNorm);
+    if(bNorm == 0.0)
+        bNorm = 1.0;
+
+    resNorm = sqrt(rNorm)/bNorm;
+    if(resNorm < tol)
+        return 0;
+
+    P->apply(r, z);
+    #pragma omp parallel for reduction(+:rz)
+    for(int i=0; i<n; i++)
+    {
+        p[i] = z[i];
+        rz += r[i]*z[i];
+    }
+
+    for(iter=1; iter<=maxIter; iter++)
+    {
+        if(S != NULL)
+            S->multiply(p, q);
+        else
+            A->multiply(p, q);
+        pq = 0.0;
+        #pragma omp parallel for reduction(+:pq)
+        for(int i=0; i<n; i++)
+            pq += p[i]*q[i];
+        alpha = rz/pq;
+
+        rNorm = 0.0;
+        #pragma omp parallel for reduction(+:rNorm)
+        for(int i=0; i<n; i++)
+        {
+            x[i] += alpha*p[i];
+            r[i] -= alpha*q[i];
+            rNorm += r[i]*r[i];
+        }
+        resNorm = sqrt(rNorm)/bNorm;
+        if(resNorm < tol)
+            break;
+
+        P->apply(r, z);
+        rzOld = rz;
+        rz = 0.0;
+        #pragma omp parallel for reduction(+:rz)
+        for(int i=0; i<n; i++)
+            rz += r[i]*z[i];
+        beta = rz/rzOld;
+
+        #pragma omp parallel for
+        for(int i=0; i<n; i++)
+            p[i] = z[i] + beta*p[i];
+    }
+
+    if(iter > maxIter)
+    {
+        cout << "> Warning! CG did not converge in " << maxIter << " iterations, relative residual: "
+             << resNorm << endl;
+        iter = maxIter;
+    }
+
+    return iter;
+}
@@ -0,0 +1,143 @@
+//==================================================================================================
+// Name        : linearSolver.h
+// Author      :
+// Version     : 1.0
+// Copyright   : See the copyright notice in the README file.
+// Description : Preconditioned conjugate gradient solver and preconditioners for the symmetric
+//               positive definite systems of the implicit solver.
+//==================================================================================================
+
+#ifndef LINEARSOLVER_H_
+#define LINEARSOLVER_H_
+
+#include "sparse.h"
+
+/*!
+ * \brief This class defines the PRECONDITIONER INTERFACE.
+ *
+ * A preconditioner is set up once from the system matrix and then applied as z = P^{-1} r in
+ * every iteration of the conjugate gradient solver.
+ */
+class preconditioner
+{
+    public:
+        /// DESTRUCTOR
+        virtual ~preconditioner(){};
+
+        /// PUBLIC INTERFACE METHODS
+        virtual void setup(csrMatrix*) = 0;
+        virtual void apply(const double*, double*) = 0;
+};
+
+
+/*!
+ * \brief This class defines the JACOBI (DIAGONAL) PRECONDITIONER.
+ */
+class jacobiPreconditioner : public preconditioner
+{
+    private:
+        /// PRIVATE VARIABLES
+        int     n;          // size of the system
+        double* invDiag;    // inverse of the diagonal of the matrix
+
+    protected:
+
+    public:
+        /// DEFAULT CONSTRUCTOR
+        jacobiPreconditioner(){n=0; invDiag=NULL;};
+
+        /// DESTRUCTOR
+        ~jacobiPreconditioner(){delete[] invDiag;};
+
+        /// PUBLIC INTERFACE METHODS
+        void setup(csrMatrix*);
+        void apply(const double*, double*);
+};
+
+
+/*!
+ * \brief This class defines the INCOMPLETE CHOLESKY IC(0) PRECONDITIONER.
+ *
+ * The factor L has the sparsity pattern of the lower triangle of the matrix. It is stored as a
+ * copy of the matrix in which only the entries left of the diagonal and the diagonal are used.
+ */
+class ic0Preconditioner : public preconditioner
+{
+    private:
+        /// PRIVATE VARIABLES
+        int         n;      // size of the system
+        csrMatrix*  L;      // incomplete Cholesky factor (lower triangle)
+        int*        diag;   // position of the diagonal entry in each row of L
+
+    protected:
+
+    public:
+        /// DEFAULT CONSTRUCTOR
+        ic0Preconditioner(){n=0; L=NULL; diag=NULL;};
+
+        /// DESTRUCTOR
+        ~ic0Preconditioner()
+        {
+            delete L;
+            delete[] diag;
+        };
+
+        /// PUBLIC INTERFACE METHODS
+        void setup(csrMatrix*);
+        void apply(const double*, double*);
+};
+
+
+/*!
+ * \brief This class defines the PRECONDITIONED CONJUGATE GRADIENT SOLVER.
+ *
+ * The work vectors are allocated once in setup(), so repeated solves with the same matrix (one per
+ * time step) do not allocate memory. If a SELL-C-sigma copy of the matrix is given with setSell(),
+ * the mat-vec products use it, the preconditioner always works on the CSR matrix.
+ */
+class pcgSolver
+{
+    private:
+        /// PRIVATE VARIABLES
+        int             n;          // size of the system
+        csrMatrix*      A;          // system matrix
+        sellMatrix*     S;          // SELL-C-sigma copy of A for the mat-vec (optional)
+        preconditioner* P;          // preconditioner
+        double          tol;        // relative residual tolerance
+        int             maxIter;    // maximum number of iterations
+        double*         r;          // residual
+        double*         z;          // preconditioned residual
+        double*         p;          // search direction
+        double*         q;          // A*p
+        double          resNorm;    // relative residual of the last solve
+
+    protected:
+
+    public:
+        /// DEFAULT CONSTRUCTOR
+        pcgSolver(){n=0; A=NULL; S=NULL; P=NULL; r=NULL; z=NULL; p=NULL; q=NULL;};
+
+        /// DESTRUCTOR
+        ~pcgSolver()
+        {
+            delete[] r;
+            delete[] z;
+            delete[] p;
+            delete[] q;
+        };
+
+        /// SETTERS
+        void setSell(sellMatrix* argS)  {S = argS;};
+
+        /// GETTERS
+        double getResNorm() {return resNorm;};
+
+        /// PUBLIC INTERFACE METHODS
+        void setup(csrMatrix*, preconditioner*, double, int);
+        int  solve(const double*, double*);
+};
+
+/// Creates the preconditioner with the given name (jacobi/ic0/amg)
+preconditioner* createPreconditioner(string);
+
+#endif /* LINEARSOLVER_H_ */
@@ -0,0 +1,44 @@
+//==================================================================================================
+// Name        : meshCompiler.cpp
+// Author      :
+// Version     : 1.0
+// Copyright   : See the copyright notice in the README file.
+// Description : Converts the mesh files of settings.in (minf, mxyz, mien, mrng) into one compiled
+//               mesh file (.cmesh), which the solver reads with "cmesh <file>" without decoding.
+//               The mesh is scaled and reordered as given in settings.in before it is written.
+//               Usage : meshCompiler [output file], the default is the cmesh file of settings.in.
+//==================================================================================================
+
+#include "settings.h"
+#include "tri.h"
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+    inputSettings*  settings    = new inputSettings;
+    triMesh*        mesh        = new triMesh;
+
+    settings->readSettingsFile();
+
+    string name = (argc > 1 ? string(argv[1]) : settings->getCmesh());
+    if(name == "none")
+    {
+        cout << "Usage : meshCompiler <output file> (or set cmesh in settings.in)" << endl;
+        exit(0);
+    }
+
+    /// Read the mesh files and number the mesh as the solver would
+    cout << "====== Mesh =====" << endl;
+    mesh->readBinaryFiles(settings);
+    if(settings->getReorder() != "none")
+        mesh->reorderMesh(settings->getReorder());
+
+    mesh->writeCompiledMesh(name, settings);
+
+    delete settings;
+    delete mesh;
+
+    cout << endl << "Ciao :)" << endl;
+    return 0;
+}
@@ -14,14 +14,45 @@
  *
  */
 void postProcessor::postProcessorControl(inputSettings* argSettings, triMesh* argMesh, int ts, double time)
+{
+        postProcessorControl(argSettings, argMesh, ts, time, NULL, argSettings->getTitle());
+
+        return;
+}
+
+/*! \brief postProcessorControl for a given field
+ *
+ * Same as above, but the temperature is taken from argField (node order of the mesh) and the file
+ * names from argTitle instead of the mesh nodes and the settings. The mesh nodes are not read, so
+ * this is used by the output thread (asyncWriter) while the solver goes on.
+ *
+ */
+void postProcessor::postProcessorControl(inputSettings* argSettings, triMesh* argMesh, int ts,
+                                         double time, const double* argField, string argTitle)
 {
         cout << endl << "===== Post-processing: time = "<<time<<" s =====" << endl;
 
         mesh = argMesh;
         settings = argSettings;
+        field = argField;
+        title = argTitle;
         
         evaluateLimits();
-        vtkVisualization(ts, time);
+        if(settings->getOutput() == "vtu")
+                vtuOutput(ts, time);
+        else if(settings->getOutput() == "legacy")
+                legacyOutput(ts, time);
+        else if(settings->getOutput() == "series")
+                seriesOutput(ts, time);
+#ifdef USE_VTK
+        else if(settings->getOutput() == "vtklib")
+                vtkVisualization(ts, time);
+#endif
+        else
+        {
+                cout << "Unknown output format : " << settings->getOutput() << "! Aborting..." << endl;
+                exit(0);
+        }
         
         return;
 }
@@ -43,7 +74,7 @@ void postProcessor::evaluateLimits()
         ///Find max and min.
         for(int i=0; i<nn; i++)
         {
-        T = mesh->getNode(i)->getT();
+        T = nodeT(i);
                 if(T < minT)
                         minT = T;
                 if(T > maxT)
@@ -55,6 +86,20 @@ void postProcessor::evaluateLimits()
         return;
 }
 
+/*! \brief Output file name
+ *
+ * <title>.<time step><extension>
+ *
+ */
+string postProcessor::fileName(int ts, string extension)
+{
+        ostringstream ss;
+        ss << title << "." << ts << extension;
+
+        return ss.str();
+}
+
+#ifdef USE_VTK
 /*! \brief Main visualization function
  *
  * Writes time stamped VTK datasets for visualization.
@@ -72,8 +117,10 @@ void postProcessor::vtkVisualization(int ts, double time)
         pcoords->SetNumberOfTuples(nn);
 
         /// vtkDoubleArray type pcoords is filled with the data in meshPoints.
+        /// Nodes and elements are written in the numbering of the mesh files.
         for (int i=0; i<nn; i++)
-        pcoords->SetTuple3(i,mesh->getNode(i)->getX(),mesh->getNode(i)->getY(),0.0f);
+        pcoords->SetTuple3(i,mesh->getNode(mesh->getNodeIndex(i))->getX(),
+                             mesh->getNode(mesh->getNodeIndex(i))->getY(),0.0f);
 
         /// vtkPoints type outputPoints is filled with the data in pcoords.
         vtkPoints* outputPoints = vtkPoints::New();
@@ -85,14 +132,15 @@ void postProcessor::vtkVisualization(int ts, double time)
         {
             connectivity->InsertNextCell(nen);
             for(int j=0; j<nen; j++)
-                connectivity->InsertCellPoint(mesh->getElem(i)->getConn(j));
+                connectivity->InsertCellPoint(
+                    mesh->getOrigNode(mesh->getElem(mesh->getElemIndex(i))->getConn(j)));
         }
 
         /// Scalar property
         vtkDoubleArray* pressure = vtkDoubleArray::New();
         pressure->SetName("Temperature");
         for(int i=0; i<nn; i++)
-            pressure->InsertNextValue(mesh->getNode(i)->getT());
+            pressure->InsertNextValue(nodeT(mesh->getNodeIndex(i)));
 
         /// Previously collected data which are outputPoints, outputCells, scalarProperty, are written to
         /// vtkPolyData type polydata var.
@@ -105,7 +153,7 @@ void postProcessor::vtkVisualization(int ts, double time)
         /// vtkDataSetWriter is for leagacy VTK format, vtkXMLDataSetWriter is for VTK XML format.
         vtkPolyDataWriter *writer = vtkPolyDataWriter::New();
         ///vtkXMLDataSetWriter *writer = vtkXMLDataSetWriter::New();
-        dummy = settings->getTitle();
+        dummy = title;
         dummy.append(".");
     	ostringstream ss; ss << ts;
         dummy.append(ss.str());
@@ -202,3 +250,330 @@ void postProcessor::vtkVisualization(int ts, double time)
 
         return;
 }
+#endif
+
+/*! \brief Block buffer for binary output
+ *
+ * Values are copied into a buffer of outputBlock bytes which is written to the file when it is
+ * full, so the mesh arrays are streamed to the file without a copy of a whole array and without a
+ * write call per value. With bigEndian the bytes of every value are swapped on the way (legacy
+ * VTK files are big-endian).
+ *
+ */
+class outputBuffer
+{
+    private:
+        ofstream&   file;
+        bool        swap;
+        char        buf[outputBlock];
+        int         pos;
+
+    public:
+        outputBuffer(ofstream& argFile, bool bigEndian) : file(argFile), pos(0)
+        {
+            const int one = 1;
+            swap = (bigEndian && *(const char*)&one == 1);
+        };
+
+        ~outputBuffer() {flush();};
+
+        void put(double value)
+        {
+            unsigned long long u;
+            memcpy(&u, &value, sizeof(u));
+            if(swap) u = __builtin_bswap64(u);
+            putBytes(&u, sizeof(u));
+        };
+        void put(int value)
+        {
+            unsigned int u = (unsigned int)value;
+            if(swap) u = __builtin_bswap32(u);
+            putBytes(&u, sizeof(u));
+        };
+        void put(unsigned long long value)
+        {
+            if(swap) value = __builtin_bswap64(value);
+            putBytes(&value, sizeof(value));
+        };
+        void put(unsigned char value) {putBytes(&value, 1);};
+
+        void putBytes(const void* p, int n)
+        {
+            if(pos + n > outputBlock) flush();
+            memcpy(buf + pos, p, n);
+            pos += n;
+        };
+        void flush()
+        {
+            file.write(buf, pos);
+            pos = 0;
+        };
+};
+
+/*! \brief VTK XML unstructured grid output (.vtu)
+ *
+ * Writes the mesh and the temperature as a .vtu file with raw binary data in the appended section
+ * (native byte order, UInt64 block sizes). The XML header holds the offset of every array in the
+ * appended section, the arrays follow one after the other:
+ * TIME, points (x, y, 0), connectivity, offsets, cell types (5 = triangle), temperature.
+ * Nodes and elements are written in the numbering of the mesh files.
+ *
+ */
+void postProcessor::vtuOutput(int ts, double time)
+{
+        int nn = mesh->getNn();
+        int ne = mesh->getNe();
+        string name = fileName(ts, ".vtu");
+
+        ofstream file(name.c_str(), ios::out|ios::binary|ios::trunc);
+        if (file.is_open()==false)
+        {
+            cout << "Unable to open file : " << name << endl;
+            exit(0);
+        }
+
+        /// Size and offset of each appended array, each one is preceded by its size (UInt64)
+        unsigned long long bytes[6] = {sizeof(double), 3ULL*nn*sizeof(double), 3ULL*ne*sizeof(int),
+                                       1ULL*ne*sizeof(int), 1ULL*ne, 1ULL*nn*sizeof(double)};
+        unsigned long long offset[6];
+        offset[0] = 0;
+        for(int k=1; k<6; k++)
+            offset[k] = offset[k-1] + sizeof(unsigned long long) + bytes[k-1];
+
+        const int one = 1;
+        file << "<?xml version=\"1.0\"?>\n"
+             << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\""
+             << (*(const char*)&one == 1 ? "LittleEndian" : "BigEndian") << "\" header_type=\"UInt64\">\n"
+             << "<UnstructuredGrid>\n"
+             << "<FieldData>\n"
+             << "<DataArray type=\"Float64\" Name=\"TIME\" NumberOfTuples=\"1\" format=\"appended\" offset=\"" << offset[0] << "\"/>\n"
+             << "</FieldData>\n"
+             << "<Piece NumberOfPoints=\"" << nn << "\" NumberOfCells=\"" << ne << "\">\n"
+             << "<PointData Scalars=\"Temperature\">\n"
+             << "<DataArray type=\"Float64\" Name=\"Temperature\" format=\"appended\" offset=\"" << offset[5] << "\"/>\n"
+             << "</PointData>\n"
+             << "<Points>\n"
+             << "<DataArray type=\"Float64\" NumberOfComponents=\"3\" format=\"appended\" offset=\"" << offset[1] << "\"/>\n"
+             << "</Points>\n"
+             << "<Cells>\n"
+             << "<DataArray type=\"Int32\" Name=\"connectivity\" format=\"appended\" offset=\"" << offset[2] << "\"/>\n"
+             << "<DataArray type=\"Int32\" Name=\"offsets\" format=\"appended\" offset=\"" << offset[3] << "\"/>\n"
+             << "<DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\"" << offset[4] << "\"/>\n"
+             << "</Cells>\n"
+             << "</Piece>\n"
+             << "</UnstructuredGrid>\n"
+             << "<AppendedData encoding=\"raw\">\n_";
+
+        {
+            outputBuffer out(file, false);
+
+            out.put(bytes[0]);
+            out.put(time);
+
+            out.put(bytes[1]);
+            for(int i=0; i<nn; i++)
+            {
+                triNode* n = mesh->getNode(mesh->getNodeIndex(i));
+                out.put(n->getX());
+                out.put(n->getY());
+                out.put(0.0);
+            }
+
+            out.put(bytes[2]);
+            for(int e=0; e<ne; e++)
+                for(int j=0; j<nen; j++)
+                    out.put(mesh->getOrigNode(mesh->getElem(mesh->getElemIndex(e))->getConn(j)));
+
+            out.put(bytes[3]);
+            for(int e=0; e<ne; e++)
+                out.put(nen*(e+1));
+
+            out.put(bytes[4]);
+            for(int e=0; e<ne; e++)
+                out.put((unsigned char)5);
+
+            out.put(bytes[5]);
+            for(int i=0; i<nn; i++)
+                out.put(nodeT(mesh->getNodeIndex(i)));
+        }
+
+        file << "\n</AppendedData>\n</VTKFile>\n";
+        file.close();
+
+        return;
+}
+
+/*! \brief Legacy binary VTK output (.vtk)
+ *
+ * Writes the same polygonal dataset as vtkVisualization() (points, triangles as polygons, the
+ * temperature as point scalars and TIME as field data) in the legacy VTK format with BINARY data,
+ * which is big-endian. Nodes and elements are written in the numbering of the mesh files.
+ *
+ */
+void postProcessor::legacyOutput(int ts, double time)
+{
+        int nn = mesh->getNn();
+        int ne = mesh->getNe();
+        string name = fileName(ts, ".vtk");
+
+        ofstream file(name.c_str(), ios::out|ios::binary|ios::trunc);
+        if (file.is_open()==false)
+        {
+            cout << "Unable to open file : " << name << endl;
+            exit(0);
+        }
+
+        file << "# vtk DataFile Version 3.0\n" << title << "\nBINARY\nDATASET POLYDATA\n"
+             << "FIELD FieldData 1\nTIME 1 1 double\n";
+        {
+            outputBuffer out(file, true);
+            out.put(time);
+        }
+
+        file << "\nPOINTS " << nn << " double\n";
+        {
+            outputBuffer out(file, true);
+            for(int i=0; i<nn; i++)
+            {
+                triNode* n = mesh->getNode(mesh->getNodeIndex(i));
+                out.put(n->getX());
+                out.put(n->getY());
+                out.put(0.0);
+            }
+        }
+
+        file << "\nPOLYGONS " << ne << " " << (nen+1)*ne << "\n";
+        {
+            outputBuffer out(file, true);
+            for(int e=0; e<ne; e++)
+            {
+                out.put(nen);
+                for(int j=0; j<nen; j++)
+                    out.put(mesh->getOrigNode(mesh->getElem(mesh->getElemIndex(e))->getConn(j)));
+            }
+        }
+
+        file << "\nPOINT_DATA " << nn << "\nSCALARS Temperature double\nLOOKUP_TABLE default\n";
+        {
+            outputBuffer out(file, true);
+            for(int i=0; i<nn; i++)
+                out.put(nodeT(mesh->getNodeIndex(i)));
+        }
+        file << "\n";
+        file.close();
+
+        return;
+}
+
+/*! \brief Time series output (.xmf with shared geometry)
+ *
+ * The mesh is written once and only the temperature of each output step is added:
+ *   <title>.mesh.bin  points (x, y, 0) as doubles followed by the connectivity as ints, written at
+ *                     the first step of the series
+ *   <title>.T.bin     temperature of every output step, nn doubles per step, appended
+ *   <title>.xmf       XDMF temporal collection opened by ParaView, one grid per output step that
+ *                     points to the shared geometry and to its block of <title>.T.bin
+ * All binary data is in native byte order. A series starts at time step 0 (or if there is no
+ * .xmf file yet), after that each step appends to the .T.bin file and replaces the closing tags
+ * of the .xmf file by its grid, so the cost of a step does not grow with the number of steps.
+ * Nodes and elements are written in the numbering of the mesh files.
+ *
+ */
+void postProcessor::seriesOutput(int ts, double time)
+{
+        int nn = mesh->getNn();
+        int ne = mesh->getNe();
+        string meshName = title + ".mesh.bin";
+        string fieldName = title + ".T.bin";
+        string indexName = title + ".xmf";
+        const string closing = "</Grid>\n</Domain>\n</Xdmf>\n";
+
+        ifstream test(indexName.c_str());
+        bool first = (ts == 0 || test.is_open() == false);
+        test.close();
+
+        /// Geometry, written once per series
+        if(first)
+        {
+            ofstream file(meshName.c_str(), ios::out|ios::binary|ios::trunc);
+            if (file.is_open()==false)
+            {
+                cout << "Unable to open file : " << meshName << endl;
+                exit(0);
+            }
+            outputBuffer out(file, false);
+            for(int i=0; i<nn; i++)
+            {
+                triNode* n = mesh->getNode(mesh->getNodeIndex(i));
+                out.put(n->getX());
+                out.put(n->getY());
+                out.put(0.0);
+            }
+            for(int e=0; e<ne; e++)
+                for(int j=0; j<nen; j++)
+                    out.put(mesh->getOrigNode(mesh->getElem(mesh->getElemIndex(e))->getConn(j)));
+        }
+
+        /// Temperature of the step, appended as block k of the field file
+        long long k;
+        {
+            ofstream file(fieldName.c_str(), ios::out|ios::binary|(first ? ios::trunc : ios::app));
+            if (file.is_open()==false)
+            {
+                cout << "Unable to open file : " << fieldName << endl;
+                exit(0);
+            }
+            file.seekp(0, ios::end);
+            k = (long long)file.tellp()/((long long)nn*sizeof(double));
+            outputBuffer out(file, false);
+            for(int i=0; i<nn; i++)
+                out.put(nodeT(mesh->getNodeIndex(i)));
+        }
+
+        /// Grid of the step in the index file
+        const int one = 1;
+        string endian = (*(const char*)&one == 1 ? "Little" : "Big");
+        ostringstream grid;
+        grid.precision(16);
+        grid << "<Grid Name=\"" << title << "." << ts << "\" GridType=\"Uniform\">\n"
+             << "<Time Value=\"" << time << "\"/>\n"
+             << "<Topology TopologyType=\"Triangle\" NumberOfElements=\"" << ne << "\">\n"
+             << "<DataItem Format=\"Binary\" NumberType=\"Int\" Precision=\"4\" Endian=\"" << endian
+             << "\" Seek=\"" << 3LL*nn*sizeof(double) << "\" Dimensions=\"" << ne << " " << nen << "\">"
+             << meshName << "</DataItem>\n"
+             << "</Topology>\n"
+             << "<Geometry GeometryType=\"XYZ\">\n"
+             << "<DataItem Format=\"Binary\" NumberType=\"Float\" Precision=\"8\" Endian=\"" << endian
+             << "\" Dimensions=\"" << nn << " 3\">" << meshName << "</DataItem>\n"
+             << "</Geometry>\n"
+             << "<Attribute Name=\"Temperature\" AttributeType=\"Scalar\" Center=\"Node\">\n"
+             << "<DataItem Format=\"Binary\" NumberType=\"Float\" Precision=\"8\" Endian=\"" << endian
+             << "\" Seek=\"" << k*nn*(long long)sizeof(double) << "\" Dimensions=\"" << nn << "\">"
+             << fieldName << "</DataItem>\n"
+             << "</Attribute>\n"
+             << "</Grid>\n";
+
+        fstream file;
+        if(first)
+        {
+            file.open(indexName.c_str(), ios::out|ios::trunc);
+            file << "<?xml version=\"1.0\"?>\n"
+                 << "<Xdmf Version=\"2.0\">\n"
+                 << "<Domain>\n"
+                 << "<Grid Name=\"" << title << "\" GridType=\"Collection\" CollectionType=\"Temporal\">\n";
+        }
+        else
+        {
+            file.open(indexName.c_str(), ios::in|ios::out);
+            file.seekp(-(long long)closing.size(), ios::end);
+        }
+        if (file.is_open()==false)
+        {
+            cout << "Unable to open file : " << indexName << endl;
+            exit(0);
+        }
+        file << grid.str() << closing;
+        file.close();
+
+        return;
+}
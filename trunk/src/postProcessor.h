@@ -14,6 +14,7 @@
 
 #include "solver.h"
 
+#ifdef USE_VTK
 #include <vtkCellArray.h>
 #include <vtkDoubleArray.h>
 #include <vtkFloatArray.h>
@@ -35,6 +36,7 @@
 #include <vtkSmartPointer.h>
 #include <vtkLookupTable.h>
 #include <vtkScalarBarActor.h>
+#endif
 
 /*! \brief 
  * This class contains post processing routines and
@@ -49,24 +51,32 @@ class postProcessor
         triMesh*        mesh;       // a local pointer for the mesh
         double          minT;       // min value of the Temperature field
         double          maxT;       // max value of the Temperature field
+        const double*   field;      // temperature of the nodes to be written (NULL = mesh nodes)
+        string          title;      // title of the output files
 
         /// PRIVATE METHODS
+        double nodeT(int i) {return (field==NULL ? mesh->getNode(i)->getT() : field[i]);};
         void evaluateLimits();
+        string fileName(int ts, string extension);
+#ifdef USE_VTK
         void vtkVisualization(int ts, double time);
-        // Here you can include your own postProcessing routine which creates the legacy VTK file
-        // without using the VTK library.
+#endif
+        void vtuOutput(int ts, double time);
+        void legacyOutput(int ts, double time);
+        void seriesOutput(int ts, double time);
 
     protected:
 
     public:
         /// DEFAULT CONSTRUCTOR
-        postProcessor(){};
+        postProcessor(){field=NULL;};
 
         /// DESTRUCTOR
         ~postProcessor(){};
 
         /// PUBLIC INTERFACE METHOD
         void postProcessorControl(inputSettings*, triMesh*, int, double);
+        void postProcessorControl(inputSettings*, triMesh*, int, double, const double*, string);
 };
 
 
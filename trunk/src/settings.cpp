@@ -21,6 +21,8 @@ inputSettings::inputSettings()
     mrngFile = "mrng";
     dataFile = "data";
     restart  = "no";
+    reorder  = "none";
+    cmeshFile = "none";
     scale    = 1.0;
     initT = 0.0;
     D = 1.0;
@@ -29,7 +31,41 @@ inputSettings::inputSettings()
     source = 0.0;
     nIter = 1;
     dt = 1.0;
+    autoDt = false;
+    safety = 0.9;
+    adapt = "no";
+    adaptTol = 1.0;
+    dtMax = numeric_limits<double>::max();
     dwf = 1;
+#ifdef USE_VTK
+    output = "vtklib";
+#else
+    output = "legacy";
+#endif
+    kernel = "exact";
+    opType = "element";
+    format = "csr";
+    sellSigma = 256;
+    tBlock = 1;
+    tileKB = 1024;
+    precision = "double";
+    nThreads = 1;
+    async = 0;
+    mode = "transient";
+    integrator = "euler";
+    theta = 1.0;
+    precond = "jacobi";
+    tol = 1e-10;
+    maxIter = 1000;
+    ensembleFile = "none";
+    nMembers = 0;
+    memberS = NULL;
+    memberBC = NULL;
+    sweepFile = "none";
+    nCases = 0;
+    caseMat = NULL;
+    caseBC = NULL;
+    caseHTC = NULL;
     BC[0].BCType = 0;
     BC[0].BCValue = 0;
     BC[0].HTC = 0;
@@ -64,7 +100,11 @@ void inputSettings::readSettingsFile()
         if (lineString.c_str()[0] != '#')
         {
             istringstream iss(lineString);
+            dummyString = "";
             iss >> dummyString;
+            // Blank line (no keyword)
+            if(dummyString == "")
+                continue;
             if(dummyString == "title")
                 iss >> title;
             else if(dummyString == "wdir")
@@ -81,6 +121,10 @@ void inputSettings::readSettingsFile()
                 iss >> dataFile;
             else if(dummyString == "restart")
                 iss >> restart;
+            else if(dummyString == "reorder")
+                iss >> reorder;
+            else if(dummyString == "cmesh")
+                iss >> cmeshFile;
             else if(dummyString == "scale")
                 iss >> scale;
             else if(dummyString == "init")
@@ -96,9 +140,64 @@ void inputSettings::readSettingsFile()
             else if(dummyString == "iter")
                 iss >> nIter;
             else if(dummyString == "dt")
-                iss >> dt;
+            {
+                string dtValue;
+                iss >> dtValue;
+                autoDt = (dtValue == "auto");
+                if(!autoDt)
+                    istringstream(dtValue) >> dt;
+            }
+            else if(dummyString == "safety")
+                iss >> safety;
+            else if(dummyString == "adapt")
+            {
+                iss >> adapt;
+                if(adapt == "yes")
+                    iss >> adaptTol;
+            }
+            else if(dummyString == "dtmax")
+                iss >> dtMax;
             else if(dummyString == "dwf")
                 iss >> dwf;
+            else if(dummyString == "output")
+                iss >> output;
+            else if(dummyString == "kernel")
+                iss >> kernel;
+            else if(dummyString == "operator")
+                iss >> opType;
+            else if(dummyString == "format")
+            {
+                iss >> format;
+                if(format == "sell")
+                    iss >> sellSigma;
+            }
+            else if(dummyString == "tblock")
+            {
+                iss >> tBlock;
+                iss >> tileKB;
+            }
+            else if(dummyString == "precision")
+                iss >> precision;
+            else if(dummyString == "threads")
+                iss >> nThreads;
+            else if(dummyString == "async")
+                iss >> async;
+            else if(dummyString == "mode")
+                iss >> mode;
+            else if(dummyString == "integrator")
+                iss >> integrator;
+            else if(dummyString == "theta")
+                iss >> theta;
+            else if(dummyString == "precond")
+                iss >> precond;
+            else if(dummyString == "tol")
+                iss >> tol;
+            else if(dummyString == "maxit")
+                iss >> maxIter;
+            else if(dummyString == "ensemble")
+                iss >> ensembleFile;
+            else if(dummyString == "sweep")
+                iss >> sweepFile;
             else if(dummyString == "fg1")
             {
                 iss >> BC[1].BCType;
@@ -171,25 +270,227 @@ void inputSettings::readSettingsFile()
     cout << "Name of the initial distribution file   : " << dataFile  << endl;
     cout << "Write restart file			     : " << restart   << endl;
     cout << "Mesh scaling factor		     : " << scale     << endl;
+    cout << "Mesh reordering                         : " << reorder   << endl;
+    cout << "Compiled mesh file                      : " << cmeshFile << endl;
     cout << "Initial value of the dependent variable : " << initT  << endl;
     cout << "Diffusion coefficient                   : " << D     << endl;
     cout << "Density                                 : " << rho   << endl;
     cout << "Specific Heat Capacity                  : " << cp    << endl;
     cout << "Source term                             : " << source     << endl;
     cout << "Number of maximum time steps            : " << nIter  << endl;
+    if(autoDt)
+    cout << "Time step size                          : auto (safety factor " << safety << ")" << endl;
+    else
     cout << "Time step size                          : " << dt    << endl;
+    cout << "Adaptive time step                      : " << adapt << endl;
+    if(adapt == "yes")
+    {
+    cout << "Target temperature change per time step : " << adaptTol << endl;
+    cout << "Maximum time step size                  : " << dtMax << endl;
+    }
     cout << "Data Writing Frequency                  : " << dwf    << endl;
+    cout << "Output format                           : " << output << endl;
+    cout << "Element kernel                          : " << kernel << endl;
+    cout << "Explicit operator storage               : " << opType << endl;
+    if(format == "sell")
+    cout << "Assembled matrix format                 : sell (C = " << sellC << ", sigma = " << sellSigma << ")" << endl;
+    else
+    cout << "Assembled matrix format                 : " << format << endl;
+    if(tBlock > 1)
+    cout << "Temporal blocking                       : " << tBlock << " steps, tiles of " << tileKB << " KB" << endl;
+    cout << "Element operator precision              : " << precision << endl;
+    cout << "Number of threads                       : " << nThreads << endl;
+    if(async > 0)
+    cout << "Output thread snapshot buffers          : " << async << endl;
+    else
+    cout << "Output thread snapshot buffers          : none (output in the time loop)" << endl;
+    cout << "Solution mode                           : " << mode << endl;
+    cout << "Time integration scheme                 : " << integrator << endl;
+    if(integrator == "theta" || mode == "steady")
+    {
+    if(mode != "steady")
+    cout << "Theta                                   : " << theta << endl;
+    cout << "Preconditioner                          : " << precond << endl;
+    cout << "Linear solver tolerance                 : " << tol << endl;
+    cout << "Linear solver maximum iterations        : " << maxIter << endl;
+    }
     cout << "Type and value of BC on FG1             : " << BC[1].BCType << " " << BC[1].BCValue << endl;
     cout << "Type and value of BC on FG2             : " << BC[2].BCType << " " << BC[2].BCValue << endl;
     cout << "Type and value of BC on FG3             : " << BC[3].BCType << " " << BC[3].BCValue << endl;
     cout << "Type and value of BC on FG4             : " << BC[4].BCType << " " << BC[4].BCValue << endl;
     cout << "Type and value of BC on FG5             : " << BC[5].BCType << " " << BC[5].BCValue << " " << BC[5].HTC << endl;
     cout << "Type and value of BC on FG6             : " << BC[6].BCType << " " << BC[6].BCValue << " " << BC[6].HTC << endl;
+    inputFile.close();
+
+    if(ensembleFile != "none")
+        readEnsembleFile();
+    if(sweepFile != "none")
+        readSweepFile();
+
     cout << endl << endl;
 
+    return;
+}
+
+//==================================================================================================
+// void inputSettings::readEnsembleFile()
+//==================================================================================================
+/* Reads the members of an ensemble run. Every line that is not empty or a comment is one member,
+ * given as pairs of a keyword and a value which replace the values of settings.in :
+ *		S <source>	fg1 <value> ... fg6 <value>
+ * e.g. "S 1e5 fg1 500". Only values that do not change the operator can be varied: the source
+ * and the BC values (Dirichlet temperature, Neumann flux, Robin ambient temperature). BC types
+ * and heat transfer coefficients are those of settings.in.
+ */
+//==================================================================================================
+void inputSettings::readEnsembleFile()
+{
+    string lineString;
+    string key;
+    double value;
+
+    ifstream inputFile;
+    inputFile.open(ensembleFile.c_str(),ios::in);
+    if (inputFile.is_open()==false)
+    {
+        cout << "Unable to open ensemble file " << ensembleFile << "! Aborting... " << endl;
+        exit(0);
+    }
+
+    ///Count the members first
+    nMembers = 0;
+    while (getline(inputFile, lineString))
+        if (!lineString.empty() && lineString[0] != '#' && lineString.find_first_not_of(" \t") != string::npos)
+            nMembers++;
+    if (nMembers == 0)
+    {
+        cout << "No members in the ensemble file " << ensembleFile << "! Aborting... " << endl;
+        exit(0);
+    }
+
+    memberS = new double [nMembers];
+    memberBC = new double [7*nMembers];
+
+    inputFile.clear();
+    inputFile.seekg(0);
+    int m = 0;
+    while (getline(inputFile, lineString))
+    {
+        if (lineString.empty() || lineString[0] == '#' || lineString.find_first_not_of(" \t") == string::npos)
+            continue;
+
+        memberS[m] = source;
+        for(int fg=0; fg<7; fg++)
+            memberBC[7*m+fg] = BC[fg].BCValue;
+
+        istringstream iss(lineString);
+        while (iss >> key >> value)
+        {
+            if (key == "S")
+                memberS[m] = value;
+            else if (key.size() == 3 && key.compare(0, 2, "fg") == 0 && key[2] >= '1' && key[2] <= '6')
+                memberBC[7*m + key[2]-'0'] = value;
+            else
+            {
+                cout << endl << "Unknown keyword in the ensemble file : " << key;
+                cout << endl << "Aborting...";
+                exit(0);
+            }
+        }
+        m++;
+    }
     inputFile.close();
-    
+
+    cout << "Ensemble members                        : " << nMembers << " (" << ensembleFile << ")" << endl;
+
     return;
 }
 
+//==================================================================================================
+// void inputSettings::readSweepFile()
+//==================================================================================================
+/* Reads the cases of a parameter sweep. Every line that is not empty or a comment is one case,
+ * given as pairs of a keyword and a value which replace the values of settings.in :
+ *		D <diffusivity>  rho <density>  cp <heat capacity>  S <source>
+ *		fg1 <value> ... fg6 <value>	htc1 <HTC> ... htc6 <HTC>
+ * e.g. "D 2e-4 rho 8000 fg5 320". BC types are those of settings.in, since they decide which
+ * nodes are solved for.
+ */
+//==================================================================================================
+void inputSettings::readSweepFile()
+{
+    string lineString;
+    string key;
+    double value;
+
+    ifstream inputFile;
+    inputFile.open(sweepFile.c_str(),ios::in);
+    if (inputFile.is_open()==false)
+    {
+        cout << "Unable to open sweep file " << sweepFile << "! Aborting... " << endl;
+        exit(0);
+    }
+
+    ///Count the cases first
+    nCases = 0;
+    while (getline(inputFile, lineString))
+        if (!lineString.empty() && lineString[0] != '#' && lineString.find_first_not_of(" \t") != string::npos)
+            nCases++;
+    if (nCases == 0)
+    {
+        cout << "No cases in the sweep file " << sweepFile << "! Aborting... " << endl;
+        exit(0);
+    }
+
+    caseMat = new double [4*nCases];
+    caseBC = new double [7*nCases];
+    caseHTC = new double [7*nCases];
+
+    inputFile.clear();
+    inputFile.seekg(0);
+    int c = 0;
+    while (getline(inputFile, lineString))
+    {
+        if (lineString.empty() || lineString[0] == '#' || lineString.find_first_not_of(" \t") == string::npos)
+            continue;
+
+        caseMat[4*c] = D;
+        caseMat[4*c+1] = rho;
+        caseMat[4*c+2] = cp;
+        caseMat[4*c+3] = source;
+        for(int fg=0; fg<7; fg++)
+        {
+            caseBC[7*c+fg] = BC[fg].BCValue;
+            caseHTC[7*c+fg] = BC[fg].HTC;
+        }
+
+        istringstream iss(lineString);
+        while (iss >> key >> value)
+        {
+            if (key == "D")
+                caseMat[4*c] = value;
+            else if (key == "rho")
+                caseMat[4*c+1] = value;
+            else if (key == "cp")
+                caseMat[4*c+2] = value;
+            else if (key == "S")
+                caseMat[4*c+3] = value;
+            else if (key.size() == 3 && key.compare(0, 2, "fg") == 0 && key[2] >= '1' && key[2] <= '6')
+                caseBC[7*c + key[2]-'0'] = value;
+            else if (key.size() == 4 && key.compare(0, 3, "htc") == 0 && key[3] >= '1' && key[3] <= '6')
+                caseHTC[7*c + key[3]-'0'] = value;
+            else
+            {
+                cout << endl << "Unknown keyword in the sweep file : " << key;
+                cout << endl << "Aborting...";
+                exit(0);
+            }
+        }
+        c++;
+    }
+    inputFile.close();
+
+    cout << "Sweep cases                             : " << nCases << " (" << sweepFile << ")" << endl;
 
+    return;
+}
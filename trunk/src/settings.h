@@ -26,7 +26,7 @@ class bndc
         
     public:
         ///DEFAULT CONSTRUCTOR
-        bndc(){};
+        bndc(){BCType = 0; BCValue = 0.0; HTC = 0.0;};
 
         ///DESTRUCTOR
         ~bndc(){};
@@ -63,6 +63,8 @@ class inputSettings
         string  dataFile;   // data file name
         string  restart;    // restart file writing (yes/no)
 	double	scale;      // scaling factor for dimensions (mm to m or vice versa)
+        string  reorder;    // renumbering of the mesh after load (none/rcm/hilbert)
+        string  cmeshFile;  // compiled mesh file used instead of the mesh files ("none" = off)
         double  initT;      // initial value of the temperature
         double  D;          // Diffusion coefficient
         double  rho;        // Density
@@ -70,8 +72,38 @@ class inputSettings
         double  source;     // Heat source term
         int     nIter;      // number of maximum time steps
         double  dt;         // time step size
+        bool    autoDt;     // time step is set from the stability limit ("dt auto")
+        double  safety;     // fraction of the stable time step used with "dt auto"
+        string  adapt;      // adaptive time step control (yes/no)
+        double  adaptTol;   // target of the maximum temperature change per time step
+        double  dtMax;      // upper limit of the adaptive time step
         int     dwf;        // Data write frequency
+        string  output;     // format of the output files (vtu/legacy/vtklib)
+        string  kernel;     // element matrix computation (exact/quadrature)
+        string  opType;     // storage of the explicit operator (element/assembled/edge/matrixfree)
+        string  format;     // storage format of assembled matrices (csr/sell)
+        int     sellSigma;  // sorting window of the SELL-C-sigma format
+        int     tBlock;     // time steps per tile of the temporally blocked solver (1 = off)
+        int     tileKB;     // cache size (KB) that the data of one tile should fit in
+        string  precision;  // precision of the element operator (double/mixed/check)
+        int     nThreads;   // number of OpenMP threads
+        int     async;      // snapshot buffers of the output thread (0 = output in the time loop)
+        string  mode;       // solution mode (transient/steady)
+        string  integrator; // time integration scheme (euler/theta/rkc/lts)
+        double  theta;      // implicitness of the theta scheme (1 = backward Euler, 0.5 = CN)
+        string  precond;    // preconditioner of the linear solver (jacobi/ic0/amg)
+        double  tol;        // relative residual tolerance of the linear solver
+        int     maxIter;    // maximum number of iterations of the linear solver
         bndc    BC[7];      // 5 face groups (4 side edges and one for internal nodes)
+        string  ensembleFile;   // file with the members of an ensemble run ("none" = off)
+        int     nMembers;       // number of ensemble members
+        double* memberS;        // source term of each member
+        double* memberBC;       // BC value of each member and face group, [member*7 + fg]
+        string  sweepFile;      // file with the cases of a parameter sweep ("none" = off)
+        int     nCases;         // number of sweep cases
+        double* caseMat;        // D, rho, cp and source of each case, [case*4 + i]
+        double* caseBC;         // BC value of each case and face group, [case*7 + fg]
+        double* caseHTC;        // heat transfer coefficient of each case and face group
         
     protected:
 
@@ -80,7 +112,18 @@ class inputSettings
         inputSettings();
 
         /// DESTRUCTOR
-        ~inputSettings(){};
+        ~inputSettings()
+        {
+            delete[] memberS;
+            delete[] memberBC;
+            delete[] caseMat;
+            delete[] caseBC;
+            delete[] caseHTC;
+        };
+
+        /// SETTERS ///
+        void            setDt(double value)     {dt = value;};
+        void            setTitle(string value)  {title = value;};
 
         /// GETTERS ///  
         string          getTitle()      {return title;};
@@ -91,6 +134,8 @@ class inputSettings
         string          getMrngFile()   {return mrngFile;};
         string          getDataFile()   {return dataFile;};
         string          getRestart()    {return restart;};
+        string          getReorder()    {return reorder;};
+        string          getCmesh()      {return cmeshFile;};
         double          getScale()      {return scale;};
         double          getInitT()      {return initT;};
         double          getD()          {return D;};
@@ -100,10 +145,45 @@ class inputSettings
         bndc*           getBC(int i)    {return &BC[i];};
         int             getNIter()      {return nIter;};
         double          getDt()         {return dt;};
+        bool            getAutoDt()     {return autoDt;};
+        double          getSafety()     {return safety;};
+        string          getAdapt()      {return adapt;};
+        double          getAdaptTol()   {return adaptTol;};
+        double          getDtMax()      {return dtMax;};
         int             getDwf()        {return dwf;};
-
-        /// PUBLIC INTERFACE METHOD
+        string          getOutput()     {return output;};
+        string          getKernel()     {return kernel;};
+        string          getOperator()   {return opType;};
+        string          getFormat()     {return format;};
+        int             getSellSigma()  {return sellSigma;};
+        int             getTBlock()     {return tBlock;};
+        int             getTileKB()     {return tileKB;};
+        string          getPrecision()  {return precision;};
+        int             getNThreads()   {return nThreads;};
+        int             getAsync()      {return async;};
+        string          getMode()       {return mode;};
+        string          getIntegrator() {return integrator;};
+        double          getTheta()      {return theta;};
+        string          getPrecond()    {return precond;};
+        double          getTol()        {return tol;};
+        int             getMaxIter()    {return maxIter;};
+        string          getEnsemble()   {return ensembleFile;};
+        int             getNMembers()   {return nMembers;};
+        double          getMemberS(int m)           {return memberS[m];};
+        double          getMemberBC(int m, int fg)  {return memberBC[7*m+fg];};
+        string          getSweep()      {return sweepFile;};
+        int             getNCases()     {return nCases;};
+        double          getCaseD(int c)             {return caseMat[4*c];};
+        double          getCaseRho(int c)           {return caseMat[4*c+1];};
+        double          getCaseCp(int c)            {return caseMat[4*c+2];};
+        double          getCaseS(int c)             {return caseMat[4*c+3];};
+        double          getCaseBC(int c, int fg)    {return caseBC[7*c+fg];};
+        double          getCaseHTC(int c, int fg)   {return caseHTC[7*c+fg];};
+
+        /// PUBLIC INTERFACE METHODS
         void readSettingsFile();
+        void readEnsembleFile();
+        void readSweepFile();
 };
 
 
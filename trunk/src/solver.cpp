@@ -8,6 +8,9 @@
 
 #include "solver.h"
 #include "postProcessor.h"
+#include "asyncWriter.h"
+#include "linearSolver.h"
+#include "elementKernel.h"
 
 //==================================================================================================
 // solverControl
@@ -17,203 +20,227 @@ void femSolver::solverControl(inputSettings* argSettings, triMesh* argMesh)
     mesh = argMesh;
     settings = argSettings;
 
-    ///Calculate Jacobian for all elements
-    for(int e=0;e<mesh->getNe();e++)
-    	femSolver::calculateJacobian(e);
+#ifdef _OPENMP
+    omp_set_num_threads(settings->getNThreads());
+    cout<<"> Running with "<<settings->getNThreads()<<" OpenMP thread(s)."<<endl;
+#endif
+
+    ///Jacobian, element matrices and lumped mass of all elements in one sweep
+    double setupTime = wallTime();
+    if(settings->getKernel()=="exact"){
+	femSolver::setupElements<exactRule>();
+    }else if(settings->getKernel()=="quadrature"){
+	femSolver::setupElements<triGauss7>();
+    }else{
+	cout<<"Unknown element kernel : "<<settings->getKernel()<<"! Aborting..."<<endl;
+	exit(0);
+    }
 
-    ///Calculate element matrices for all elements
-    for(int e=0;e<mesh->getNe();e++)
-	femSolver::calculateElementMatrices(e);
+    ///Apply the boundary conditions on the elements with a boundary face. Nodes on two Dirichlet
+    ///boundaries take the value of the last element visited, so the elements are visited in the
+    ///order of the mesh files.
+    for(int e=0;e<mesh->getNe();e++){
+	triElement* elem = mesh->getElem(mesh->getElemIndex(e));
+	if(elem->getFG(0)!=0 || elem->getFG(1)!=0 || elem->getFG(2)!=0)
+		femSolver::applyBoundaryConditions(mesh->getElemIndex(e));
+    }
 
-    ///Apply the boundary conditions 
-    for(int e=0;e<mesh->getNe();e++)
-	femSolver::applyBoundaryConditions(e);
+    setupTime = wallTime() - setupTime;
+    cout<<"> Setup of "<<mesh->getNe()<<" elements: "<<setupTime<<" s ("
+	<<mesh->getNe()/setupTime<<" elements/s)"<<endl;
 
-    ///Solve the equation system 
-    femSolver::explicitSolver();
+    ///Stable time step of the explicit scheme and the time step to be used
+    if(settings->getMode()=="transient")
+	femSolver::setTimeStep();
 
-    return;
-}
+    postP = new postProcessor;
+    if(settings->getAsync()>0){
+	writer = new asyncWriter;
+	writer->start(settings, mesh, settings->getAsync());
+    }
 
-//==================================================================================================
-// calculateJacobian
-//==================================================================================================
-void femSolver::calculateJacobian(const int e)
-{
-    int* conn = new int[3]();
-    double* X = new double[3]();
-    double* Y = new double[3]();
+    ///Solve the equation system 
+    if(settings->getMode()=="steady"){
+	femSolver::globalAssembly();
+	femSolver::steadySolver();
+    }else if(settings->getMode()!="transient"){
+	cout<<"Unknown solution mode : "<<settings->getMode()<<"! Aborting..."<<endl;
+	exit(0);
+    }else if(settings->getIntegrator()=="theta"){
+	femSolver::globalAssembly();
+	femSolver::implicitSolver();
+    }else if(settings->getIntegrator()=="rkc"){
+	soa = new triMeshSoA;
+	soa->build(mesh);
+	if(settings->getNThreads()>1)
+		soa->colourElements();
+	femSolver::rkcSolver();
+    }else if(settings->getIntegrator()=="lts"){
+	femSolver::ltsSolver();
+    }else if(settings->getIntegrator()!="euler"){
+	cout<<"Unknown time integration scheme : "<<settings->getIntegrator()<<"! Aborting..."<<endl;
+	exit(0);
+    }else if(settings->getEnsemble()!="none"){
+	soa = new triMeshSoA;
+	soa->build(mesh);
+	if(settings->getNThreads()>1)
+		soa->colourElements();
+	femSolver::explicitEnsembleSolver();
+    }else if(settings->getSweep()!="none"){
+	femSolver::explicitSweepSolver();
+    }else if(settings->getOperator()=="assembled" && settings->getTBlock()>1){
+	femSolver::globalAssembly();
+	femSolver::explicitBlockedSolver();
+    }else if(settings->getOperator()=="assembled"){
+	femSolver::globalAssembly();
+	femSolver::explicitAssembledSolver();
+    }else if(settings->getOperator()=="edge"){
+	femSolver::globalAssembly();
+	femSolver::explicitEdgeSolver();
+    }else if(settings->getOperator()=="matrixfree"){
+	soa = new triMeshSoA;
+	soa->build(mesh, false);
+	if(settings->getNThreads()>1)
+		soa->colourElements();
+	femSolver::explicitMatrixFreeSolver();
+    }else if(settings->getOperator()=="element"){
+	soa = new triMeshSoA;
+	soa->build(mesh);
+	if(settings->getNThreads()>1)
+		soa->colourElements();
+	if(settings->getPrecision()=="double"){
+		femSolver::explicitSolver<double>();
+	}else if(settings->getPrecision()=="mixed"){
+		soa->convertK(false);
+		femSolver::explicitSolver<float>();
+	}else if(settings->getPrecision()=="check"){
+		femSolver::precisionCheck();
+	}else{
+		cout<<"Unknown precision : "<<settings->getPrecision()<<"! Aborting..."<<endl;
+		exit(0);
+	}
+    }else{
+	cout<<"Unknown operator storage : "<<settings->getOperator()<<"! Aborting..."<<endl;
+	exit(0);
+    }
 
-    ///Access the coordinates of the nodes of the element 'e'
-    for(int i=0;i<3;i++){
-	conn[i] = mesh->getElem(e)->getConn(i);
-	X[i] = mesh->getNode(conn[i])->getX();
-	Y[i] = mesh->getNode(conn[i])->getY();
+    if(writer!=NULL){
+	writer->finish();
+	delete writer;
+	writer = NULL;
     }
+    delete postP;
+    postP = NULL;
 
-    ///Access the derivatives of shape functions
-    ///dSdXi and dSdEta are constant for the reference element so it is sufficient to access values
-    ///for 0th Master element.
-    double* dSdXi = new double[3]();
-    double* dSdEta = new double[3]();
-    for(int i=0;i<3;i++){
-	dSdXi[i] = mesh->getME(0)->getDSdKsi(i);
-	dSdEta[i] = mesh->getME(0)->getDSdEta(i);
-    }
-
-    ///Matrix-Matrix multiplication for calculation of Jacobian Matrix
-    ///		     _	        _
-    ///		    | J[0]  J[1] |
-    ///		J = | 		 |
-    ///		    |_J[2]  J[3]_|		
-		    
-    double* J = new double[4]();
-    for(int j=0;j<3;j++){
-	J[0] = J[0] + dSdXi[j]*X[j];
-	J[1] = J[1] + dSdXi[j]*Y[j];
-	J[2] = J[2] + dSdEta[j]*X[j];
-	J[3] = J[3] + dSdEta[j]*Y[j];
-    }
-    
-    ///Set the Jacobian matrix for each element
-    mesh->getElem(e)->setJ(J);
-
-    ///Calculate determinant of J
-    double det_J = J[0]*J[3] - J[1]*J[2];
-    mesh->getElem(e)->setDetJ(fabs(det_J));
-
-    ///Invert Jacobian Matrix by Adjoint method
-    double* J_inv = new double[4]();
-    J_inv[0] = J[3]/det_J;
-    J_inv[1] = -J[1]/det_J;
-    J_inv[2] = -J[2]/det_J;
-    J_inv[3] = J[0]/det_J;
-
-    ///Set the Inverse of Jacobian matrix for each element
-    mesh->getElem(e)->setJinv(J_inv);
-
-    delete[] conn;
-    delete[] X;
-    delete[] Y;
-    delete[] dSdXi;
-    delete[] dSdEta;
-    delete[] J;
-    delete[] J_inv;
     return;
 }
 
 //==================================================================================================
-// calculateElementMatrices
+// setupElements
 //==================================================================================================
-void femSolver::calculateElementMatrices(const int e)
+/* Fused setup of all elements in one sweep :
+ * Elements are processed in batches of setupBatch. For each batch
+ * 1- the node coordinates are gathered into [node][element] arrays on the stack (the last element
+ *    is repeated to fill the final batch),
+ * 2- the Jacobian J = [X1-X0, Y1-Y0; X2-X0, Y2-Y0] of the linear triangle and its determinant are
+ *    computed,
+ * 3- the element kernel (elementKernel.h) computes K, M_l and F for the whole batch,
+ * 4- everything is scattered to the element level structure, B is reset.
+ * No memory is allocated in the loop, the Jacobian and kernel loops run over the batch with unit
+ * stride.
+ */
+//==================================================================================================
+template<class Rule>
+void femSolver::setupElements()
 {
-    double K[9] = {0.0};
-    double M[9] = {0.0};
-    double dSdX[3] = {0.0};
-    double dSdY[3] = {0.0};
-    double F[3] = {0.0};
-    double S[3] = {0.0};
-
-    ///Access the derivatives of shape functions
-    ///dSdXi and dSdEta are constant for the reference element so it is sufficient to access values
-    ///for 0th Master element.
-    double dSdXi[3] = {0.0};
-    double dSdEta[3] = {0.0};
+    int ne = mesh->getNe();
+
+    ///Data blocks of the element matrices
+    mesh->allocElementData();
 
     ///Get Diffusion coefficient
     double k = settings->getD();
 
-    ///Access the coordinates of the nodes of the element 'e'
-    double X[3], Y[3];
-    int conn[3];
-    for(int i=0;i<3;i++){
-	conn[i] = mesh->getElem(e)->getConn(i);
-	X[i] = mesh->getNode(conn[i])->getX();
-	Y[i] = mesh->getNode(conn[i])->getY();
-    }
-
-    ///Get absolute value of determinant of Jacobian
-    double det_J_abs = mesh->getElem(e)->getDetJ();
-
     /// Calculate the right hand side source term
     double source = settings->getSource()/(settings->getRho() * settings->getCp());
 
-    double weight;
-    ///Gauss Quadrature rule for integration
-    for(int g=0;g<nGQP;g++){
-
-	/// Access weight for current gauss point
-	weight = mesh->getME(g)->getWeight();
-
-	///Access Shape function values
-    	for(int i=0;i<3;i++)
-		S[i] = mesh->getME(g)->getS(i);
-
-	///Access derivatives of shape functions
-    	for(int i=0;i<3;i++){
-		dSdXi[i] = mesh->getME(g)->getDSdKsi(i);
-		dSdEta[i] = mesh->getME(g)->getDSdEta(i);
-	}
-     
-        ///Evaluate dSdX and dSdY at Gauss Quadrature Points. 
-        for(int i=0;i<3;i++){
-		dSdX[i] = mesh->getElem(e)->getJinv()[0]*dSdXi[i] + mesh->getElem(e)->getJinv()[1]*dSdEta[i];
-		dSdY[i] = mesh->getElem(e)->getJinv()[2]*dSdXi[i] + mesh->getElem(e)->getJinv()[3]*dSdEta[i];
-        }
- 
-        ///Construct the element matrix
-	for(int i=0;i<3;i++){
-		for(int j=0;j<3;j++){
-			K[3*i+j] = K[3*i+j] + \
-				  k*(dSdX[i]*dSdX[j] + dSdY[i]*dSdY[j])*det_J_abs*weight;
+    #pragma omp parallel for schedule(static)
+    for(int e0=0;e0<ne;e0+=setupBatch){
+	double X[3][setupBatch], Y[3][setupBatch], J[4][setupBatch], det_J[setupBatch];
+	double K[9][setupBatch], M_l[3][setupBatch], F[3][setupBatch];
+	int nb = (ne-e0<setupBatch ? ne-e0 : setupBatch);
 
+	///Access the coordinates of the nodes of the elements
+	for(int b=0;b<setupBatch;b++){
+		triElement* elem = mesh->getElem(e0 + (b<nb ? b : nb-1));
+		for(int i=0;i<3;i++){
+			triNode* node = mesh->getNode(elem->getConn(i));
+			X[i][b] = node->getX();
+			Y[i][b] = node->getY();
 		}
 	}
 
-	///Construct the mass matrix
-	for(int i=0;i<3;i++){
-		for(int j=0;j<3;j++){
-			M[3*i+j] = M[3*i+j] + S[i]*S[j]*det_J_abs*weight;
-		}
-	}
-	
-	///Construct the element level Source vector
-	for(int i=0;i<3;i++){
-		if(Y[i]>=0.0004)
-			F[i] = F[i] + S[i]*source*det_J_abs*weight;
+	///Jacobian matrix (dS/dksi = (-1,1,0), dS/deta = (-1,0,1)) and its determinant
+	///		     _	        _
+	///		    | J[0]  J[1] |
+	///		J = | 		 |
+	///		    |_J[2]  J[3]_|
+	#pragma omp simd
+	for(int b=0;b<setupBatch;b++){
+		J[0][b] = X[1][b] - X[0][b];
+		J[1][b] = Y[1][b] - Y[0][b];
+		J[2][b] = X[2][b] - X[0][b];
+		J[3][b] = Y[2][b] - Y[0][b];
+		det_J[b] = J[0][b]*J[3][b] - J[1][b]*J[2][b];
 	}
 
-    }//GQR loop end
-
-    ///Set the element matrix in element level structure
-    mesh->getElem(e)->setK(K);
-
-    ///Lumping of Mass matrix for all elements
-
-    ///Initialize sums
-    double sum_all = 0.0;
-    double sum_diag = 0.0;
-
-    ///Lumped mass matrix is diagonal matrix so only diagonal is stored
-    double M_l[3] = {0.0};
-
-    ///Sum of all elements
-    for(int i=0;i<9;i++)
-	sum_all = sum_all + M[i];
-
-    //Sum of diagonal elements
-    for(int i=0;i<3;i++)
-	sum_diag = sum_diag + M[3*i+i];
+	///Element matrices
+	elementKernel<triP1, Rule>::template computeBatch<setupBatch>(X, Y, k, source, K, M_l, F);
+
+	///Set everything in element level structure
+	for(int b=0;b<nb;b++){
+		triElement* elem = mesh->getElem(e0+b);
+		double Je[4], J_inv[4], Ke[9], Me[3], Fe[3];
+		double B[3] = {0.0};
+
+		for(int i=0;i<4;i++)
+			Je[i] = J[i][b];
+		J_inv[0] = Je[3]/det_J[b];
+		J_inv[1] = -Je[1]/det_J[b];
+		J_inv[2] = -Je[2]/det_J[b];
+		J_inv[3] = Je[0]/det_J[b];
+		for(int i=0;i<9;i++)
+			Ke[i] = K[i][b];
+		for(int i=0;i<3;i++){
+			Me[i] = M_l[i][b];
+			Fe[i] = F[i][b];
+		}
 
-    ///Lumped local mass matrix (only diagonal elements)
-    for(int i=0;i<3;i++)
-	M_l[i] = M[3*i+i]*sum_all/sum_diag;
+		elem->setJ(Je);
+		elem->setJinv(J_inv);
+		elem->setDetJ(fabs(det_J[b]));
+		elem->setK(Ke);
+		elem->setM(Me);
+		elem->setF(Fe);
+		elem->setB(B);
+	}
+    }
 
-    ///Set the mass matrix in element level structure
-    mesh->getElem(e)->setM(M_l);
+    return;
+}
 
-    ///Set the element matrix in element level structure
-    mesh->getElem(e)->setF(F);
+//==================================================================================================
+// unitElement
+// Element matrices of one element for k = 1 and a unit source, with the element kernel of the
+// settings ("kernel exact" or "quadrature") as in setupElements(). Used by the drivers which
+// assemble unit operators and rescale them per member or case.
+//==================================================================================================
+void femSolver::unitElement(const double* X, const double* Y, double* Ke, double* Me, double* Fe)
+{
+    if(settings->getKernel()=="exact")
+	elementKernel<triP1, exactRule>::compute(X, Y, 1.0, 1.0, Ke, Me, Fe);
+    else
+	elementKernel<triP1, triGauss7>::compute(X, Y, 1.0, 1.0, Ke, Me, Fe);
 
     return;
 }
@@ -383,92 +410,860 @@ void femSolver::applyBoundaryConditions(const int e)
 //==================================================================================================
 // explicitSolver
 //==================================================================================================
+/* The time loop works on the structure-of-arrays copy of the mesh (triMeshSoA). Everything that
+ * does not change in time is folded into two node arrays before the loop :
+ *		dtInvM = dt/M_l,	dtFB = dt*(F + B)/M_l
+ * both zero on Dirichlet nodes, so these keep their value without a branch. A time step is then
+ *	1- the element loop, which streams the connectivity and K and accumulates R = -K*T,
+ *	2- one node sweep, which computes T_new = T + dtFB + dtInvM*R, tracks the rate of change and
+ *	   the maximum temperature and resets R for the next step.
+ * Real is the type in which K is stored (double, or float for "precision mixed"). Temperatures,
+ * the node arrays and the accumulation of R stay in double.
+ */
+//==================================================================================================
+template<class Real>
 void femSolver::explicitSolver()
 {
-    ///Element level variables
-    int conn[3];
-    double RHS_e[3];
-    double M_l[3];
-
-    ///Node level variables
-    int nn = mesh->getNn();
-    double* M = new double [nn]();
-    double* RHS = new double [nn]();
+    ///Structure-of-arrays mesh data
+    int nn = soa->getNn();
+    int ne = soa->getNe();
+    int nColours = soa->getNColours();
+    int* colourPtr = soa->getColourPtr();
+    int* conn0 = soa->getConn(0);
+    int* conn1 = soa->getConn(1);
+    int* conn2 = soa->getConn(2);
+    Real* K[9];
+    for(int i=0;i<9;i++)
+	soa->getK(i, K[i]);
+    double* T = soa->getT();
+    int* BC_type = soa->getBC_type();
 
     double time = 0.0;
     double dt = settings->getDt();
-    postProcessor*  postP = new postProcessor;
+
+    ///Node level variables
+    double* dtInvM = new double [nn]();
+    double* dtFB = new double [nn]();
+    double* R = new double [nn]();
+
+    for(int e=0;e<ne;e++){
+	for(int i=0;i<3;i++){
+		dtInvM[soa->getConn(i)[e]] += soa->getM(i)[e];
+		dtFB[soa->getConn(i)[e]] += soa->getFB(i)[e];
+	}
+    }
+    for(int node=0;node<nn;node++){
+	dtFB[node] = (BC_type[node]!=1 ? dt*dtFB[node]/dtInvM[node] : 0.0);
+	dtInvM[node] = (BC_type[node]!=1 ? dt/dtInvM[node] : 0.0);
+    }
+
+    ///Memory traffic of one time step: element loop (connectivity, K) and node sweep (T, R,
+    ///dtInvM, dtFB read, T and R written)
+    double bytes = ne*(3*sizeof(int) + 9*sizeof(Real)) + nn*6*sizeof(double);
+    cout<<"> Explicit step moves "<<bytes/nn<<" bytes per DOF update"<<endl;
 
     ///Time loop start	
     for(int t=0;t<=settings->getNIter();t++){
 
 	///Write solution at certain time steps
-	if(t%settings->getDwf()==0)	postP->postProcessorControl(settings, mesh, t, time);
+	if(t%settings->getDwf()==0)	writeSolution(t, time, T);
+
+	double max_rate = 0.0, T_max = 0;
+
+	#pragma omp parallel
+	{
+		///Loop through all elements, colour by colour. Elements of one colour do not share
+		///nodes, so they can be assembled in parallel.
+		for(int c=0;c<nColours;c++){
+			#pragma omp for
+			for(int e=colourPtr[c];e<colourPtr[c+1];e++){
+
+				///Access the connectivity and the temperatures of the element 'e'
+				int c0 = conn0[e], c1 = conn1[e], c2 = conn2[e];
+				double T0 = T[c0], T1 = T[c1], T2 = T[c2];
+
+				///-K*T
+				R[c0] -= K[0][e]*T0 + K[1][e]*T1 + K[2][e]*T2;
+				R[c1] -= K[3][e]*T0 + K[4][e]*T1 + K[5][e]*T2;
+				R[c2] -= K[6][e]*T0 + K[7][e]*T1 + K[8][e]*T2;
+			}
+		}///element loop end
+
+		///Loop through all nodes, calculate and set the temperature (Also check if it reached steady state)
+		#pragma omp for reduction(max:max_rate,T_max)
+		for(int node=0;node<nn;node++){
+			double dT = dtFB[node] + dtInvM[node]*R[node];
+			R[node] = 0.0;
+			T[node] += dT;
+
+			// Calculate the rate of change of temperature
+			double rate = fabs(dT/dt);
+			if(rate>max_rate)	max_rate = rate;
+			if(T[node]>T_max)	T_max = T[node]; 
+		}
+	}
 
-   	///Initialize node level variables
-	for(int node=0;node<nn;node++){
-		M[node] = 0.0;
-		RHS[node] = 0.0;
+	if(max_rate<0.001){
+		cout<<">> Solution reached Steady state! \n"<<endl;
+		cout<<"> Maximum temperature in the domain: "<<T_max<<" K\ttime = "<<time<<" s\n"<<endl;
+		break;
 	}
 
-	///Loop through all elements
-	for(int e=0;e<mesh->getNe();e++){
+	///Increase time by dt	
+	time += dt;
 
-		for(int i=0;i<3;i++)
-   			RHS_e[i] = 0.0;	
+	///Adapt the time step to the change of the solution, the node coefficients scale with dt
+	if(settings->getAdapt()=="yes"){
+		double dtNew = adaptTimeStep(dt, max_rate*dt);
+		if(dtNew!=dt){
+			for(int node=0;node<nn;node++){
+				dtInvM[node] *= dtNew/dt;
+				dtFB[node] *= dtNew/dt;
+			}
+			dt = dtNew;
+		}
+	}
 
-		///Construct element level Right Hand Side
-	    	///Access the connectivity of the element 'e'
-	    	for(int i=0;i<3;i++)
-			conn[i] = mesh->getElem(e)->getConn(i);
+    }///Time loop end
 
-	    	///K[i][j]*T[j]
-	    	for(int i=0;i<3;i++){
-			for(int j=0;j<3;j++){
-		    		RHS_e[i] = RHS_e[i] + mesh->getElem(e)->getK()[3*i+j] * mesh->getNode(conn[j])->getT();
-			}	
-	    	}
+    ///Copy the final field back to the mesh
+    soa->scatterT(mesh);
 
-		///dt*(F + B - K*T)
-		for(int i=0;i<3;i++){
-			RHS_e[i] = dt*(mesh->getElem(e)->getF()[i] + mesh->getElem(e)->getB()[i] - RHS_e[i]);
-	    	}
+    delete[] dtInvM;
+    delete[] dtFB;
+    delete[] R;
+    return;
+}
 
-		///Access lumped mass matrix 
-		std::memcpy(M_l,mesh->getElem(e)->getM(),3*sizeof(double));
-		
-		///M[3][3]*T[3] + dt(F + B - K*T)
-		for(int i=0;i<3;i++)
-			RHS_e[i] = RHS_e[i] + M_l[i]*mesh->getNode(conn[i])->getT();
-	
-		///Assemble global Diagonal Mass matrix and RHS
-		for(int i=0;i<3;i++){
-			M[conn[i]] = M[conn[i]] + M_l[i];
-			RHS[conn[i]] = RHS[conn[i]] + RHS_e[i];
+//==================================================================================================
+// precisionCheck
+//==================================================================================================
+/* Accuracy of the mixed precision solver :
+ * The same run is done twice from the same initial field, first with K in double precision
+ * (without output files), then with K in single precision. The largest difference of the final
+ * fields is reported, absolute and relative to the largest change of the double precision field
+ * from the initial field.
+ */
+//==================================================================================================
+void femSolver::precisionCheck()
+{
+    int nn = soa->getNn();
+    double* T = soa->getT();
+    double* T0 = new double [nn];
+    double* Td = new double [nn];
+    std::memcpy(T0, T, nn*sizeof(double));
+
+    soa->convertK(true);
+
+    ///Double precision reference without output
+    postProcessor* keep = postP;
+    postP = NULL;
+    cout<<"> Precision check: double precision reference run"<<endl;
+    femSolver::explicitSolver<double>();
+    std::memcpy(Td, T, nn*sizeof(double));
+    postP = keep;
+
+    ///Mixed precision run from the same initial field
+    std::memcpy(T, T0, nn*sizeof(double));
+    cout<<"> Precision check: mixed precision run"<<endl;
+    femSolver::explicitSolver<float>();
+
+    double maxDiff = 0.0, maxChange = 0.0;
+    for(int node=0;node<nn;node++){
+	maxDiff = max(maxDiff, fabs(T[node] - Td[node]));
+	maxChange = max(maxChange, fabs(Td[node] - T0[node]));
+    }
+    cout<<"> Precision check: max |T_mixed - T_double| = "<<maxDiff<<" K, "
+	<<(maxChange>0.0 ? maxDiff/maxChange : 0.0)<<" of the largest temperature change"<<endl;
+
+    delete[] T0;
+    delete[] Td;
+    return;
+}
+
+//==================================================================================================
+// elementRate
+//==================================================================================================
+/* Stage operator of the stabilized explicit scheme :
+ *		R = M_l^{-1}*(F + B - K*T)
+ * evaluated in the same coloured element loop as explicitSolver. invM is the inverse of the
+ * assembled lumped mass. R is zero on Dirichlet nodes, so they keep their value in every stage.
+ */
+//==================================================================================================
+void femSolver::elementRate(const double* T, const double* invM, double* R)
+{
+    int nn = soa->getNn();
+    int nColours = soa->getNColours();
+    int* colourPtr = soa->getColourPtr();
+    int* conn0 = soa->getConn(0);
+    int* conn1 = soa->getConn(1);
+    int* conn2 = soa->getConn(2);
+    double* K[9];
+    for(int i=0;i<9;i++)
+	K[i] = soa->getK(i);
+    double* FB0 = soa->getFB(0);
+    double* FB1 = soa->getFB(1);
+    double* FB2 = soa->getFB(2);
+    int* BC_type = soa->getBC_type();
+
+    #pragma omp parallel
+    {
+	#pragma omp for
+	for(int node=0;node<nn;node++)
+		R[node] = 0.0;
+
+	for(int c=0;c<nColours;c++){
+		#pragma omp for
+		for(int e=colourPtr[c];e<colourPtr[c+1];e++){
+			int c0 = conn0[e], c1 = conn1[e], c2 = conn2[e];
+			double T0 = T[c0], T1 = T[c1], T2 = T[c2];
+
+			R[c0] += FB0[e] - (K[0][e]*T0 + K[1][e]*T1 + K[2][e]*T2);
+			R[c1] += FB1[e] - (K[3][e]*T0 + K[4][e]*T1 + K[5][e]*T2);
+			R[c2] += FB2[e] - (K[6][e]*T0 + K[7][e]*T1 + K[8][e]*T2);
 		}
-		
+	}
 
-	}///element loop end
+	#pragma omp for
+	for(int node=0;node<nn;node++)
+		R[node] = (BC_type[node]!=1 ? R[node]*invM[node] : 0.0);
+    }
 
-	///Loop through all nodes, calculate and set the temperature (Also check if it reached steady state)
-	double rate, max_rate = 0.0, T_prev, T_curr, T_max = 0;
-	for(int node=0;node<nn;node++){	
-		// Get previous Temperature of node
-		T_prev = mesh->getNode(node)->getT();		
-	
-		///Set the calculated temperature to the nodes which are not on the Dirichlet Boundary
-		if(mesh->getNode(node)->getBC_type()!=1)
-			mesh->getNode(node)->setT(RHS[node]/M[node]);
+    return;
+}
+
+//==================================================================================================
+// explicitEnsembleSolver
+//==================================================================================================
+/* Forward Euler for all members of an ensemble in one pass over the mesh :
+ * The members differ only in the source and the BC values, so K, M_l and the Dirichlet nodes are
+ * shared and only the forcing differs. Temperatures are stored as T[node*nm + member], so the
+ * element loop reads K and the connectivity of an element once and updates all nm members in an
+ * inner loop with unit stride.
+ * The forcing of a member is built from unit parts, which are linear in the values :
+ *	F  = S/(rho*cp) * F_1		F_1 = source vector for a unit source (exact P1 kernel)
+ *	B  = sum_fg value_fg * B_fg	B_fg = flux vector of face group fg for a unit value
+ * B_fg follows applyBoundaryConditions(): Neumann faces add L/(2*rho*cp), Robin faces
+ * HTC*L/(2*rho*cp), a later face of the same element replaces the value at a shared node. The
+ * Dirichlet value of a node is that of the face group of the last element visited.
+ * Output files are written per member as <title>.m<member>.<step>.vtk. The run stops when all
+ * members reached steady state.
+ */
+//==================================================================================================
+void femSolver::explicitEnsembleSolver()
+{
+    int nn = soa->getNn();
+    int nm = settings->getNMembers();
+    int nColours = soa->getNColours();
+    int* colourPtr = soa->getColourPtr();
+    int* conn0 = soa->getConn(0);
+    int* conn1 = soa->getConn(1);
+    int* conn2 = soa->getConn(2);
+    double* K[9];
+    for(int i=0;i<9;i++)
+	K[i] = soa->getK(i);
+    int* BC_type = soa->getBC_type();
+
+    double rhoCp = settings->getRho()*settings->getCp();
+    double time = 0.0;
+    double dt = settings->getDt();
+
+    ///Unit source vector, unit flux vectors and Dirichlet face group of the nodes
+    double* F1 = new double [nn]();
+    double* Bfg = new double [7*nn]();
+    double* Ml = new double [nn]();
+    int* dirichletFG = new int [nn]();
+    for(int e=0;e<mesh->getNe();e++){
+	triElement* elem = mesh->getElem(mesh->getElemIndex(e));
+	double X[3], Y[3], Ke[9], Me[3], Fe[3], coef[3] = {0.0, 0.0, 0.0};
+	int fgOf[3] = {0, 0, 0};
+	for(int i=0;i<3;i++){
+		X[i] = mesh->getNode(elem->getConn(i))->getX();
+		Y[i] = mesh->getNode(elem->getConn(i))->getY();
+	}
+	femSolver::unitElement(X, Y, Ke, Me, Fe);
+
+	for(int f=0;f<3;f++){
+		int FG = elem->getFG(f);
+		if(FG==0)	continue;
+		int n1 = edgeNodes[f][0], n2 = edgeNodes[f][1];
+		double L = sqrt((X[n1]-X[n2])*(X[n1]-X[n2]) + (Y[n1]-Y[n2])*(Y[n1]-Y[n2]));
+		double c = 0.0;
+		if(settings->getBC(FG)->getType()==1){
+			dirichletFG[elem->getConn(n1)] = FG;
+			dirichletFG[elem->getConn(n2)] = FG;
+		}else if(settings->getBC(FG)->getType()==2){
+			c = L/(2.0*rhoCp);
+		}else if(settings->getBC(FG)->getType()==3){
+			c = settings->getBC(FG)->getHTC()*L/(2.0*rhoCp);
+		}
+		coef[n1] = c;	fgOf[n1] = FG;
+		coef[n2] = c;	fgOf[n2] = FG;
+	}
+
+	for(int i=0;i<3;i++){
+		F1[elem->getConn(i)] += Fe[i]/rhoCp;
+		Bfg[7*elem->getConn(i) + fgOf[i]] += coef[i];
+		Ml[elem->getConn(i)] += elem->getM()[i];
+	}
+    }
+
+    ///Node level variables, member values of a node are contiguous
+    double* T = new double [nn*nm];
+    double* R = new double [nn*nm]();
+    double* dtFB = new double [nn*nm];
+    double* dtInvM = new double [nn];
+    double* Tm = new double [nn];
+    for(int node=0;node<nn;node++){
+	dtInvM[node] = (BC_type[node]!=1 ? dt/Ml[node] : 0.0);
+	for(int m=0;m<nm;m++){
+		double FB = settings->getMemberS(m)*F1[node];
+		for(int fg=1;fg<7;fg++)
+			FB += Bfg[7*node+fg]*settings->getMemberBC(m, fg);
+		dtFB[node*nm+m] = dtInvM[node]*FB;
+		T[node*nm+m] = (BC_type[node]==1 ? settings->getMemberBC(m, dirichletFG[node])
+						: soa->getT()[node]);
+	}
+    }
+    delete[] F1;
+    delete[] Bfg;
+    delete[] Ml;
+    delete[] dirichletFG;
+
+    cout<<"> Ensemble of "<<nm<<" members, the mesh is read once per time step for all members"<<endl;
+
+    string title = settings->getTitle();
 
-		// Get current Temperature of node
-		T_curr = mesh->getNode(node)->getT();
+    ///Time loop start
+    for(int t=0;t<=settings->getNIter();t++){
+
+	///Write the solution of every member at certain time steps
+	if(t%settings->getDwf()==0){
+		for(int m=0;m<nm;m++){
+			ostringstream ss; ss << title << ".m" << m;
+			settings->setTitle(ss.str());
+			for(int node=0;node<nn;node++)
+				Tm[node] = T[node*nm+m];
+			writeSolution(t, time, Tm);
+		}
+		settings->setTitle(title);
+	}
+
+	double max_dT = 0.0, T_max = 0;
+
+	#pragma omp parallel
+	{
+		///Loop through all elements, colour by colour, all members at once
+		for(int c=0;c<nColours;c++){
+			#pragma omp for
+			for(int e=colourPtr[c];e<colourPtr[c+1];e++){
+				double* T0 = T + conn0[e]*nm;
+				double* T1 = T + conn1[e]*nm;
+				double* T2 = T + conn2[e]*nm;
+				double* R0 = R + conn0[e]*nm;
+				double* R1 = R + conn1[e]*nm;
+				double* R2 = R + conn2[e]*nm;
+				double k0 = K[0][e], k1 = K[1][e], k2 = K[2][e];
+				double k3 = K[3][e], k4 = K[4][e], k5 = K[5][e];
+				double k6 = K[6][e], k7 = K[7][e], k8 = K[8][e];
+
+				#pragma omp simd
+				for(int m=0;m<nm;m++){
+					double t0 = T0[m], t1 = T1[m], t2 = T2[m];
+					R0[m] -= k0*t0 + k1*t1 + k2*t2;
+					R1[m] -= k3*t0 + k4*t1 + k5*t2;
+					R2[m] -= k6*t0 + k7*t1 + k8*t2;
+				}
+			}
+		}///element loop end
+
+		///Loop through all nodes and members, the largest change is divided by dt afterwards
+		#pragma omp for reduction(max:max_dT,T_max)
+		for(int node=0;node<nn;node++){
+			double invM = dtInvM[node];
+			double* Tn = T + node*nm;
+			double* Rn = R + node*nm;
+			double* FBn = dtFB + node*nm;
+
+			#pragma omp simd reduction(max:max_dT,T_max)
+			for(int m=0;m<nm;m++){
+				double dT = FBn[m] + invM*Rn[m];
+				Rn[m] = 0.0;
+				Tn[m] += dT;
+				max_dT = max(max_dT, fabs(dT));
+				T_max = max(T_max, Tn[m]);
+			}
+		}
+	}
+
+	double max_rate = max_dT/dt;
+	if(max_rate<0.001){
+		cout<<">> All ensemble members reached Steady state! \n"<<endl;
+		cout<<"> Maximum temperature in the ensemble: "<<T_max<<" K\ttime = "<<time<<" s\n"<<endl;
+		break;
+	}
+
+	///Increase time by dt
+	time += dt;
+
+	///Adapt the time step to the largest change of all members
+	if(settings->getAdapt()=="yes"){
+		double dtNew = adaptTimeStep(dt, max_rate*dt);
+		if(dtNew!=dt){
+			for(int i=0;i<nn*nm;i++)
+				dtFB[i] *= dtNew/dt;
+			for(int node=0;node<nn;node++)
+				dtInvM[node] *= dtNew/dt;
+			dt = dtNew;
+		}
+	}
+
+    }///Time loop end
+
+    ///The mesh keeps the field of the first member (restart file)
+    for(int node=0;node<nn;node++)
+	mesh->getNode(node)->setT(T[node*nm]);
+
+    delete[] T;
+    delete[] R;
+    delete[] dtFB;
+    delete[] dtInvM;
+    delete[] Tm;
+    return;
+}
+
+//==================================================================================================
+// explicitSweepSolver
+//==================================================================================================
+/* Parameter sweep with forward Euler, one run per case of the sweep file :
+ * All coefficients enter the equations linearly, so the operators are assembled once for unit
+ * coefficients and every case only rescales them :
+ *	K  = D*K_1 + sum_fg HTC_fg/(rho*cp) * K_R,fg	K_1 = stiffness matrix for D = 1, K_R,fg =
+ *							Robin terms of face group fg for HTC = 1
+ *	FB = S/(rho*cp)*F_1 + sum_fg c_fg*value_fg/(rho*cp) * B_fg	c_fg = HTC_fg (Robin) or 1
+ * with the unit parts of explicitEnsembleSolver(). The lumped mass and the Dirichlet nodes are
+ * the same for all cases. Per case the explicit operator A = M_l^{-1}*(M_l - dt*K) and
+ * c = dt*M_l^{-1}*FB are built in one pass over the unit matrix (no element is recomputed and the
+ * mesh is not read again), then the case runs like explicitAssembledSolver().
+ * The cases are independent and are distributed over the threads (dynamic schedule, each case
+ * runs on one thread). With "dt auto" the time step of a case is the one of settings.in scaled by
+ * the ratio of the Gershgorin bounds of the two operators, otherwise dt is used as given.
+ * Output files are written per case as <title>.c<case>.<step>.vtk.
+ */
+//==================================================================================================
+void femSolver::explicitSweepSolver()
+{
+    int nn = mesh->getNn();
+    int nc = settings->getNCases();
+
+    ///Unit stiffness matrix, source vector, flux vectors and Dirichlet face group of the nodes
+    csrMatrix* K1 = new csrMatrix;
+    K1->buildPattern(mesh);
+    double* F1 = new double [nn]();
+    double* Bfg = new double [7*nn]();
+    double* Ml = new double [nn]();
+    int* dirichletFG = new int [nn]();
+
+    ///Robin terms, four entries per face: (n1,n1), (n2,n2) with L/3 and (n1,n2), (n2,n1) with L/6
+    int nRobin = 0;
+    for(int e=0;e<mesh->getNe();e++)
+	for(int f=0;f<3;f++)
+		if(mesh->getElem(e)->getFG(f)!=0 && settings->getBC(mesh->getElem(e)->getFG(f))->getType()==3)
+			nRobin += 4;
+    int* robinEntry = new int [nRobin];
+    int* robinFG = new int [nRobin];
+    double* robinCoef = new double [nRobin];
+
+    nRobin = 0;
+    for(int e=0;e<mesh->getNe();e++){
+	triElement* elem = mesh->getElem(mesh->getElemIndex(e));
+	double X[3], Y[3], Ke[9], Me[3], Fe[3], coef[3] = {0.0, 0.0, 0.0};
+	int conn[3], fgOf[3] = {0, 0, 0};
+	for(int i=0;i<3;i++){
+		conn[i] = elem->getConn(i);
+		X[i] = mesh->getNode(conn[i])->getX();
+		Y[i] = mesh->getNode(conn[i])->getY();
+	}
+	femSolver::unitElement(X, Y, Ke, Me, Fe);
+
+	for(int f=0;f<3;f++){
+		int FG = elem->getFG(f);
+		if(FG==0)	continue;
+		int n1 = edgeNodes[f][0], n2 = edgeNodes[f][1];
+		double L = sqrt((X[n1]-X[n2])*(X[n1]-X[n2]) + (Y[n1]-Y[n2])*(Y[n1]-Y[n2]));
+		double c = 0.0;
+		if(settings->getBC(FG)->getType()==1){
+			dirichletFG[conn[n1]] = FG;
+			dirichletFG[conn[n2]] = FG;
+		}else if(settings->getBC(FG)->getType()==2 || settings->getBC(FG)->getType()==3){
+			c = L/2.0;
+		}
+		if(settings->getBC(FG)->getType()==3){
+			int ij[4][2] = {{n1, n1}, {n2, n2}, {n1, n2}, {n2, n1}};
+			for(int k=0;k<4;k++){
+				robinEntry[nRobin] = K1->findEntry(conn[ij[k][0]], conn[ij[k][1]]);
+				robinFG[nRobin] = FG;
+				robinCoef[nRobin] = (k<2 ? L/3.0 : L/6.0);
+				nRobin++;
+			}
+		}
+		coef[n1] = c;	fgOf[n1] = FG;
+		coef[n2] = c;	fgOf[n2] = FG;
+	}
+
+	for(int i=0;i<3;i++){
+		F1[conn[i]] += Fe[i];
+		Bfg[7*conn[i] + fgOf[i]] += coef[i];
+		Ml[conn[i]] += elem->getM()[i];
+		for(int j=0;j<3;j++)
+			K1->addValue(conn[i], conn[j], Ke[3*i+j]);
+	}
+    }
+
+    ///Initial field of the free nodes and the final field of the first case
+    double* T0 = new double [nn];
+    double* Tfirst = new double [nn];
+    for(int node=0;node<nn;node++)
+	T0[node] = mesh->getNode(node)->getT();
+
+    ///Gershgorin bound of the operator of settings.in, the time steps of the cases are scaled by it
+    double dtBase = settings->getDt();
+    double boundBase = 0.0;
+    {
+	double HTC[7];
+	for(int fg=0;fg<7;fg++)
+		HTC[fg] = settings->getBC(fg)->getHTC();
+	csrMatrix* Kc = new csrMatrix;
+	Kc->copyPattern(K1);
+	double* val = Kc->getVal();
+	for(int k=0;k<K1->getNnz();k++)
+		val[k] = settings->getD()*K1->getVal()[k];
+	for(int r=0;r<nRobin;r++)
+		val[robinEntry[r]] += HTC[robinFG[r]]/(settings->getRho()*settings->getCp())*robinCoef[r];
+	boundBase = sweepBound(Kc, Ml);
+	delete Kc;
+    }
+
+    cout<<"> Sweep of "<<nc<<" cases, unit operators assembled once: "<<nn<<" rows, "
+	<<K1->getNnz()<<" entries, "<<nRobin/4<<" Robin faces"<<endl;
+
+    string title = settings->getTitle();
+    double sweepTime = wallTime();
+
+    #pragma omp parallel for schedule(dynamic,1)
+    for(int ic=0;ic<nc;ic++){
+	double D = settings->getCaseD(ic);
+	double rhoCp = settings->getCaseRho(ic)*settings->getCaseCp(ic);
+
+	///Rescale the unit operators : K and FB of the case
+	csrMatrix* A = new csrMatrix;
+	A->copyPattern(K1);
+	int* rowPtr = A->getRowPtr();
+	int* col = A->getCol();
+	double* val = A->getVal();
+	for(int k=0;k<K1->getNnz();k++)
+		val[k] = D*K1->getVal()[k];
+	for(int r=0;r<nRobin;r++)
+		val[robinEntry[r]] += settings->getCaseHTC(ic, robinFG[r])/rhoCp*robinCoef[r];
+
+	double* c = new double [nn];
+	double* T = new double [nn];
+	double* T_new = new double [nn];
+	double* swap;
+	for(int node=0;node<nn;node++){
+		double FB = settings->getCaseS(ic)/rhoCp*F1[node];
+		for(int fg=1;fg<7;fg++){
+			double scale = (settings->getBC(fg)->getType()==3 ? settings->getCaseHTC(ic, fg) : 1.0);
+			FB += Bfg[7*node+fg]*scale*settings->getCaseBC(ic, fg)/rhoCp;
+		}
+		c[node] = FB;
+		T[node] = (mesh->getNode(node)->getBC_type()==1 ? settings->getCaseBC(ic, dirichletFG[node])
+								: T0[node]);
+	}
+
+	///Time step of the case
+	double dt = dtBase;
+	if(settings->getAutoDt())
+		dt = dtBase*boundBase/sweepBound(A, Ml);
+
+	///Explicit operator A = M_l^{-1}*(M_l - dt*K), c = dt*M_l^{-1}*FB, identity rows for Dirichlet
+	for(int i=0;i<nn;i++){
+		bool dirichlet = (mesh->getNode(i)->getBC_type()==1);
+		for(int k=rowPtr[i];k<rowPtr[i+1];k++){
+			if(dirichlet)
+				val[k] = (col[k]==i ? 1.0 : 0.0);
+			else
+				val[k] = (col[k]==i ? 1.0 : 0.0) - dt*val[k]/Ml[i];
+		}
+		c[i] = (dirichlet ? 0.0 : dt*c[i]/Ml[i]);
+	}
+
+	///Time loop of the case
+	double time = 0.0, T_max = 0.0;
+	int t;
+	for(t=0;t<=settings->getNIter();t++){
+
+		///Write solution at certain time steps, one case at a time
+		if(t%settings->getDwf()==0){
+			#pragma omp critical (sweepOutput)
+			{
+				ostringstream ss; ss << title << ".c" << ic;
+				settings->setTitle(ss.str());
+				writeSolution(t, time, T);
+				settings->setTitle(title);
+			}
+		}
+
+		///T_new = A*T + c, the mat-vec runs on the thread of the case
+		A->multiplyAdd(T, c, T_new);
+
+		double max_rate = 0.0;
+		T_max = 0.0;
+		for(int node=0;node<nn;node++){
+			double rate = fabs((T_new[node] - T[node])/dt);
+			if(rate>max_rate)	max_rate = rate;
+			if(T_new[node]>T_max)	T_max = T_new[node];
+		}
+
+		swap = T; T = T_new; T_new = swap;
+
+		if(max_rate<0.001)	break;
+
+		///Increase time by dt
+		time += dt;
+	}
+
+	#pragma omp critical (sweepOutput)
+	{
+		cout<<"> Case "<<ic<<" (D = "<<D<<", rho*cp = "<<rhoCp<<", S = "<<settings->getCaseS(ic)
+		    <<", dt = "<<dt<<"): "<<(t>settings->getNIter() ? t-1 : t)<<" steps"
+		    <<(t>settings->getNIter() ? "" : " (steady state)")<<", maximum temperature "
+		    <<T_max<<" K"<<endl;
+
+		///The mesh keeps the field of the first case (restart file)
+		if(ic==0)
+			for(int node=0;node<nn;node++)
+				Tfirst[node] = T[node];
+	}
+
+	delete A;
+	delete[] c;
+	delete[] T;
+	delete[] T_new;
+    }
+
+    sweepTime = wallTime() - sweepTime;
+    cout<<"> Sweep of "<<nc<<" cases: "<<sweepTime<<" s ("<<sweepTime/nc<<" s per case)"<<endl;
+
+    for(int node=0;node<nn;node++)
+	mesh->getNode(node)->setT(Tfirst[node]);
+
+    delete K1;
+    delete[] F1;
+    delete[] Bfg;
+    delete[] Ml;
+    delete[] dirichletFG;
+    delete[] robinEntry;
+    delete[] robinFG;
+    delete[] robinCoef;
+    delete[] T0;
+    delete[] Tfirst;
+    return;
+}
+
+//==================================================================================================
+// sweepBound
+// Gershgorin bound max_i sum_j |K_ij|/M_l,i of M_l^{-1}*K over the rows and columns of free nodes.
+//==================================================================================================
+double femSolver::sweepBound(csrMatrix* Kc, const double* Ml)
+{
+    int* rowPtr = Kc->getRowPtr();
+    int* col = Kc->getCol();
+    double* val = Kc->getVal();
+    double bound = 0.0;
+
+    for(int i=0;i<Kc->getNRows();i++){
+	if(mesh->getNode(i)->getBC_type()==1 || Ml[i]==0.0)	continue;
+	double sum = 0.0;
+	for(int k=rowPtr[i];k<rowPtr[i+1];k++)
+		if(mesh->getNode(col[k])->getBC_type()!=1)
+			sum += fabs(val[k]);
+	if(sum/Ml[i]>bound)	bound = sum/Ml[i];
+    }
+
+    return bound;
+}
+
+//==================================================================================================
+// rkcStages
+//==================================================================================================
+/* Number of stages of the second order Runge-Kutta-Chebyshev scheme for the time step dt. The
+ * real stability interval of the damped s-stage scheme is about 0.65*s^2, so
+ *		s = 1 + sqrt(1 + 1.54*dt*lambda_max)
+ * stages are needed. lambda_max is increased by 20% since the power iteration estimates it from
+ * below.
+ */
+//==================================================================================================
+int femSolver::rkcStages(double dt)
+{
+    int s = 1 + (int)sqrt(1.0 + 1.54*dt*1.2*lambdaMax);
+
+    return (s<2 ? 2 : s);
+}
+
+//==================================================================================================
+// rkcCoefficients
+//==================================================================================================
+/* Coefficients of the s-stage RKC2 scheme (Sommeijer, Shampine and Verwer) with damping
+ * eps = 2/13 :
+ *	w0 = 1 + eps/s^2,  w1 = T_s'(w0)/T_s''(w0),  b_j = T_j''(w0)/T_j'(w0)^2 (b_0 = b_1 = b_2)
+ *	mu_j = 2*w0*b_j/b_{j-1},  nu_j = -b_j/b_{j-2},  muT_j = 2*w1*b_j/b_{j-1}
+ *	gammaT_j = -(1 - b_{j-1}*T_{j-1}(w0))*muT_j,  muT_1 = b_1*w1
+ * T_j are the Chebyshev polynomials of the first kind. The arrays have size s+1.
+ */
+//==================================================================================================
+void femSolver::rkcCoefficients(int s, double* mu, double* nu, double* muT, double* gammaT)
+{
+    double w0 = 1.0 + (2.0/13.0)/(s*s);
+    double* Tc = new double [s+1];
+    double* dTc = new double [s+1];
+    double* ddTc = new double [s+1];
+    double* b = new double [s+1];
+
+    ///Chebyshev polynomials and their first two derivatives at w0
+    Tc[0] = 1.0;	dTc[0] = 0.0;	ddTc[0] = 0.0;
+    Tc[1] = w0;		dTc[1] = 1.0;	ddTc[1] = 0.0;
+    for(int j=2;j<=s;j++){
+	Tc[j] = 2.0*w0*Tc[j-1] - Tc[j-2];
+	dTc[j] = 2.0*Tc[j-1] + 2.0*w0*dTc[j-1] - dTc[j-2];
+	ddTc[j] = 4.0*dTc[j-1] + 2.0*w0*ddTc[j-1] - ddTc[j-2];
+    }
+    double w1 = dTc[s]/ddTc[s];
+
+    for(int j=2;j<=s;j++)
+	b[j] = ddTc[j]/(dTc[j]*dTc[j]);
+    b[0] = b[2];
+    b[1] = b[2];
+
+    mu[1] = 0.0;	nu[1] = 0.0;	muT[1] = b[1]*w1;	gammaT[1] = 0.0;
+    for(int j=2;j<=s;j++){
+	mu[j] = 2.0*w0*b[j]/b[j-1];
+	nu[j] = -b[j]/b[j-2];
+	muT[j] = 2.0*w1*b[j]/b[j-1];
+	gammaT[j] = -(1.0 - b[j-1]*Tc[j-1])*muT[j];
+    }
+
+    delete[] Tc;
+    delete[] dTc;
+    delete[] ddTc;
+    delete[] b;
+    return;
+}
+
+//==================================================================================================
+// rkcSolver
+//==================================================================================================
+/* Runge-Kutta-Chebyshev time integration :
+ * Each time step takes s stages of the element-level operator (elementRate)
+ *	Y_0 = T,  Y_1 = Y_0 + muT_1*dt*R(Y_0)
+ *	Y_j = (1 - mu_j - nu_j)*Y_0 + mu_j*Y_{j-1} + nu_j*Y_{j-2} + muT_j*dt*R(Y_{j-1})
+ *	      + gammaT_j*dt*R(Y_0)
+ *	T_new = Y_s
+ * The scheme is second order and explicit, but stable for dt up to about 0.65*s^2 times the
+ * stability limit of forward Euler, so the number of operator applications grows only with the
+ * square root of dt*lambda_max.
+ */
+//==================================================================================================
+void femSolver::rkcSolver()
+{
+    int nn = soa->getNn();
+    int nColours = soa->getNColours();
+    int* colourPtr = soa->getColourPtr();
+    int* conn0 = soa->getConn(0);
+    int* conn1 = soa->getConn(1);
+    int* conn2 = soa->getConn(2);
+    double* M0 = soa->getM(0);
+    double* M1 = soa->getM(1);
+    double* M2 = soa->getM(2);
+    double* T = soa->getT();
+
+    double* invM = new double [nn]();
+    double* R0 = new double [nn];
+    double* R = new double [nn];
+    double* Yjm2 = new double [nn];
+    double* Yjm1 = new double [nn];
+    double* Yj = new double [nn];
+
+    ///Inverse of the assembled lumped mass
+    for(int c=0;c<nColours;c++){
+	#pragma omp parallel for
+	for(int e=colourPtr[c];e<colourPtr[c+1];e++){
+		invM[conn0[e]] += M0[e];
+		invM[conn1[e]] += M1[e];
+		invM[conn2[e]] += M2[e];
+	}
+    }
+    for(int node=0;node<nn;node++)
+	invM[node] = 1.0/invM[node];
+
+    double time = 0.0;
+    double dt = settings->getDt();
+    int s = 0;
+    double *mu = NULL, *nu = NULL, *muT = NULL, *gammaT = NULL;
+    long nRates = 0;
+
+    ///Time loop start
+    for(int t=0;t<=settings->getNIter();t++){
+
+	///Write solution at certain time steps
+	if(t%settings->getDwf()==0)	writeSolution(t, time, T);
+
+	///Number of stages and coefficients for the current time step
+	if(rkcStages(dt)!=s){
+		s = rkcStages(dt);
+		delete[] mu;	delete[] nu;	delete[] muT;	delete[] gammaT;
+		mu = new double [s+1];
+		nu = new double [s+1];
+		muT = new double [s+1];
+		gammaT = new double [s+1];
+		rkcCoefficients(s, mu, nu, muT, gammaT);
+		cout<<"> RKC time step "<<dt<<" s with "<<s<<" stages"<<endl;
+	}
+
+	///First stage
+	elementRate(T, invM, R0);
+	#pragma omp parallel for
+	for(int node=0;node<nn;node++){
+		Yjm1[node] = T[node];
+		Yj[node] = T[node] + muT[1]*dt*R0[node];
+	}
+	nRates++;
+
+	///Remaining stages
+	for(int j=2;j<=s;j++){
+		double* tmp = Yjm2;
+		Yjm2 = Yjm1;
+		Yjm1 = Yj;
+		Yj = tmp;
+
+		elementRate(Yjm1, invM, R);
+		double a = 1.0 - mu[j] - nu[j];
+		#pragma omp parallel for
+		for(int node=0;node<nn;node++)
+			Yj[node] = a*T[node] + mu[j]*Yjm1[node] + nu[j]*Yjm2[node]
+				 + muT[j]*dt*R[node] + gammaT[j]*dt*R0[node];
+		nRates++;
+	}
 
-		// Calculate the rate of change of temperature
-		rate = fabs((T_curr - T_prev)/dt);
+	///Set the new temperature (Also check if it reached steady state)
+	double max_rate = 0.0, T_max = 0;
+	#pragma omp parallel for reduction(max:max_rate,T_max)
+	for(int node=0;node<nn;node++){
+		double rate = fabs((Yj[node] - T[node])/dt);
+		T[node] = Yj[node];
 		if(rate>max_rate)	max_rate = rate;
-		if(T_curr>T_max)	T_max = T_curr; 
+		if(T[node]>T_max)	T_max = T[node];
 	}
-	
 
 	if(max_rate<0.001){
 		cout<<">> Solution reached Steady state! \n"<<endl;
@@ -476,13 +1271,1219 @@ void femSolver::explicitSolver()
 		break;
 	}
 
-	///Increase time by dt	
+	///Increase time by dt
 	time += dt;
 
+	///Adapt the time step to the change of the solution
+	if(settings->getAdapt()=="yes")
+		dt = adaptTimeStep(dt, max_rate*dt);
+
     }///Time loop end
 
-    delete postP;
-    delete[] M;
-    delete[] RHS;
+    cout<<"> Number of operator applications: "<<nRates<<endl;
+
+    ///Copy the final field back to the mesh
+    soa->scatterT(mesh);
+
+    delete[] invM;
+    delete[] R0;
+    delete[] R;
+    delete[] Yjm2;
+    delete[] Yjm1;
+    delete[] Yj;
+    delete[] mu;
+    delete[] nu;
+    delete[] muT;
+    delete[] gammaT;
+    return;
+}
+
+//==================================================================================================
+// ltsSolver
+//==================================================================================================
+/* Local (multirate) time stepping with forward Euler :
+ * dt is the macro time step. Node i gets the level l_i, the smallest l for which dt/2^l is below
+ * the safety factor times its stable time step (Gershgorin bound of its row, see stableTimeStep).
+ * A macro step consists of 2^L sub-steps, L being the finest level. In sub-step k the rate of all
+ * nodes of level l with k%2^(L-l)==0 is updated,
+ *		r_i = M_l,i^{-1}*(F + B - K*T)_i
+ * and every node advances by one sub-step, T_i += dt/2^L * r_i. A node of level l thus takes a
+ * forward Euler step of dt/2^l, spread linearly over its sub-steps, and the finer neighbours see its
+ * temperature interpolated in time instead of frozen or already at the end of the step. All levels
+ * are synchronized at the end of a macro step.
+ * Only the elements of the updated nodes are evaluated, these are the first level groups of the
+ * structure-of-arrays mesh (triMeshSoA::groupLevels).
+ * With "dt auto" the finest level runs at the smallest stable time step of the nodes.
+ */
+//==================================================================================================
+void femSolver::ltsSolver()
+{
+    int nn = mesh->getNn();
+    double* dtNode = new double [nn];
+    int* level = new int [nn];
+
+    ///Stable time step of every node. For "dt auto" the finest level takes the smallest one and the
+    ///macro time step is the largest multiple 2^L of it that is still stable for some node.
+    double dtFine = stableTimeStep(dtNode);
+    double dtCoarse = 0.0;
+    for(int i=0;i<nn;i++){
+	if(dtNode[i]==numeric_limits<double>::max())	continue;
+	dtNode[i] = settings->getSafety()*dtNode[i];
+	if(dtNode[i]>dtCoarse)	dtCoarse = dtNode[i];
+    }
+    if(settings->getAutoDt()){
+	dtFine = settings->getSafety()*dtFine;
+	int L = 0;
+	while(2.0*dtFine*pow(2.0,L)<=dtCoarse && L<ltsMaxLevels-1)
+		L++;
+	settings->setDt(dtFine*pow(2.0,L));
+	cout<<"> Macro time step is set to: "<<settings->getDt()<<" s"<<endl;
+    }
+    double dt = settings->getDt();
+
+    ///Level of every node
+    bool isStable = true;
+    for(int i=0;i<nn;i++){
+	level[i] = 0;
+	while(dt/pow(2.0,level[i])>dtNode[i] && level[i]<ltsMaxLevels-1)
+		level[i]++;
+	if(dt/pow(2.0,level[i])>dtNode[i])	isStable = false;
+    }
+    if(!isStable)
+	cout<<"> Warning! More than "<<ltsMaxLevels<<" time step levels are needed for dt = "<<dt
+	    <<" s, the solution will blow up!"<<endl;
+
+    soa = new triMeshSoA;
+    soa->build(mesh);
+    soa->groupLevels(level);
+    if(settings->getNThreads()>1)
+	soa->colourElements();
+
+    delete[] dtNode;
+    delete[] level;
+
+    ///Structure-of-arrays mesh data
+    int L = soa->getNLevels()-1;
+    int* colourPtr = soa->getColourPtr();
+    int* levelPtr = soa->getLevelPtr();
+    int* levelNodes = soa->getLevelNodes();
+    int* nodeLevelPtr = soa->getNodeLevelPtr();
+    int* conn0 = soa->getConn(0);
+    int* conn1 = soa->getConn(1);
+    int* conn2 = soa->getConn(2);
+    double* K[9];
+    for(int i=0;i<9;i++)
+	K[i] = soa->getK(i);
+    double* FB0 = soa->getFB(0);
+    double* FB1 = soa->getFB(1);
+    double* FB2 = soa->getFB(2);
+    double* T = soa->getT();
+    int* BC_type = soa->getBC_type();
+
+    ///Node level variables : inverse lumped mass, RHS, rate of the last update and macro step start
+    double* invM = new double [nn]();
+    double* RHS = new double [nn];
+    double* rate = new double [nn]();
+    double* T_prev = new double [nn];
+    double dtSub = dt/(1<<L);
+
+    for(int e=0;e<soa->getNe();e++){
+	invM[conn0[e]] += soa->getM(0)[e];
+	invM[conn1[e]] += soa->getM(1)[e];
+	invM[conn2[e]] += soa->getM(2)[e];
+    }
+    for(int node=0;node<nn;node++)
+	invM[node] = (BC_type[node]!=1 ? 1.0/invM[node] : 0.0);
+
+    double time = 0.0;
+    long nElemEval = 0;
+    int nMacro = 0;
+
+    ///Time loop start (macro steps)
+    for(int t=0;t<=settings->getNIter();t++){
+
+	///Write solution at certain time steps
+	if(t%settings->getDwf()==0)	writeSolution(t, time, T);
+
+	memcpy(T_prev, T, nn*sizeof(double));
+	nMacro++;
+
+	for(int k=0;k<(1<<L);k++){
+
+		///Coarsest level updated in this sub-step, level groups 0..gLast are active
+		int lMin = L;
+		while(lMin>0 && k%(1<<(L-lMin+1))==0)
+			lMin--;
+		int gLast = L-lMin;
+		int nActive = nodeLevelPtr[gLast+1];
+		nElemEval += colourPtr[levelPtr[gLast+1]];
+
+		#pragma omp parallel
+		{
+			#pragma omp for
+			for(int i=0;i<nActive;i++)
+				RHS[levelNodes[i]] = 0.0;
+
+			for(int c=0;c<levelPtr[gLast+1];c++){
+				#pragma omp for
+				for(int e=colourPtr[c];e<colourPtr[c+1];e++){
+					int c0 = conn0[e], c1 = conn1[e], c2 = conn2[e];
+					double T0 = T[c0], T1 = T[c1], T2 = T[c2];
+
+					RHS[c0] += FB0[e] - (K[0][e]*T0 + K[1][e]*T1 + K[2][e]*T2);
+					RHS[c1] += FB1[e] - (K[3][e]*T0 + K[4][e]*T1 + K[5][e]*T2);
+					RHS[c2] += FB2[e] - (K[6][e]*T0 + K[7][e]*T1 + K[8][e]*T2);
+				}
+			}
+
+			#pragma omp for
+			for(int i=0;i<nActive;i++){
+				int node = levelNodes[i];
+				rate[node] = invM[node]*RHS[node];
+			}
+
+			///Every node advances by one sub-step with the rate of its last update
+			#pragma omp for
+			for(int node=0;node<nn;node++)
+				T[node] += dtSub*rate[node];
+		}
+	}
+
+	///Check if it reached steady state
+	double max_rate = 0.0, T_max = 0;
+	for(int node=0;node<nn;node++){
+		double dTdt = fabs((T[node] - T_prev[node])/dt);
+		if(dTdt>max_rate)	max_rate = dTdt;
+		if(T[node]>T_max)	T_max = T[node];
+	}
+
+	if(max_rate<0.001){
+		cout<<">> Solution reached Steady state! \n"<<endl;
+		cout<<"> Maximum temperature in the domain: "<<T_max<<" K\ttime = "<<time<<" s\n"<<endl;
+		break;
+	}
+
+	///Increase time by dt
+	time += dt;
+
+    }///Time loop end
+
+    cout<<"> Element evaluations: "<<nElemEval<<" ("
+	<<(double)nElemEval/((double)nMacro*soa->getNe()*(1<<L))
+	<<" of global time stepping with dt/"<<(1<<L)<<")"<<endl;
+
+    ///Copy the final field back to the mesh
+    soa->scatterT(mesh);
+
+    delete[] invM;
+    delete[] RHS;
+    delete[] rate;
+    delete[] T_prev;
+    return;
+}
+
+//==================================================================================================
+// writeSolution
+// Copies a contiguous temperature field to the mesh and writes it out, or hands it to the output
+// thread ("async"), which writes it while the time loop goes on.
+//==================================================================================================
+void femSolver::writeSolution(int ts, double time, double* T)
+{
+    for(int node=0;node<mesh->getNn();node++)
+	mesh->getNode(node)->setT(T[node]);
+
+    if(postP!=NULL && writer!=NULL)
+	writer->push(ts, time, T);
+    else if(postP!=NULL)
+	postP->postProcessorControl(settings, mesh, ts, time);
+
+    return;
+}
+
+//==================================================================================================
+// stableTimeStep
+//==================================================================================================
+/* Stability limit of forward Euler with lumped mass :
+ * The scheme is stable for dt <= 2/lambda_max, lambda_max being the largest eigenvalue of
+ * M_l^{-1}*K. It is bounded by the Gershgorin estimate of the rows of M_l^{-1}*K,
+ *		lambda_i = sum_j |K_ij| / M_l,i	<=	sum_e sum_j |K_e,ij| / M_l,i
+ * which is evaluated in an element loop. Only rows and columns of nodes that are solved for (not
+ * Dirichlet) are included. The stable time step 2/lambda_i of each node is written to dtNode if
+ * it is not NULL, the global limit is returned.
+ */
+//==================================================================================================
+double femSolver::stableTimeStep(double* dtNode)
+{
+    int nn = mesh->getNn();
+    double* rowSum = new double [nn]();
+    double* M = new double [nn]();
+    double dtMin = numeric_limits<double>::max();
+
+    for(int e=0;e<mesh->getNe();e++){
+	int conn[3];
+	bool isFree[3];
+
+	for(int i=0;i<3;i++){
+		conn[i] = mesh->getElem(e)->getConn(i);
+		isFree[i] = (mesh->getNode(conn[i])->getBC_type()!=1);
+	}
+
+	for(int i=0;i<3;i++){
+		M[conn[i]] += mesh->getElem(e)->getM()[i];
+		if(!isFree[i])	continue;
+		for(int j=0;j<3;j++)
+			if(isFree[j])	rowSum[conn[i]] += fabs(mesh->getElem(e)->getK()[3*i+j]);
+	}
+    }
+
+    for(int i=0;i<nn;i++){
+	double dtN = (rowSum[i]>0.0 ? 2.0*M[i]/rowSum[i] : numeric_limits<double>::max());
+	if(dtNode!=NULL)	dtNode[i] = dtN;
+	if(dtN<dtMin)		dtMin = dtN;
+    }
+
+    delete[] rowSum;
+    delete[] M;
+    return dtMin;
+}
+
+//==================================================================================================
+// largestEigenvalue
+//==================================================================================================
+/* Power iteration for the largest eigenvalue of M_l^{-1}*K on the nodes that are solved for :
+ *	w = M_l^{-1}*K*v,	lambda = (v,K*v)/(v,M_l*v),	v = w/||w||_M
+ * K*v is evaluated in an element loop, so no global matrix is needed. Nodes without mass (not used
+ * by any element) are left out. The iteration stops when lambda changes by less than tol relative
+ * to it, or after maxIter iterations. The Rayleigh quotient approaches lambda_max from below, so
+ * the result is an estimate that may be slightly too small.
+ */
+//==================================================================================================
+double femSolver::largestEigenvalue(int maxIter, double tol)
+{
+    int nn = mesh->getNn();
+    int conn[3];
+    double* v = new double [nn];
+    double* w = new double [nn];
+    double* M = new double [nn];
+    bool* isFree = new bool [nn];
+    double lambda = 0.0, lambdaOld;
+
+    for(int i=0;i<nn;i++)
+	M[i] = 0.0;
+    for(int e=0;e<mesh->getNe();e++)
+	for(int i=0;i<3;i++)
+		M[mesh->getElem(e)->getConn(i)] += mesh->getElem(e)->getM()[i];
+    for(int i=0;i<nn;i++){
+	isFree[i] = (mesh->getNode(i)->getBC_type()!=1 && M[i]>0.0);
+	v[i] = (isFree[i] ? ((i*7919)%1000)/1000.0 - 0.5 : 0.0);
+    }
+
+    for(int it=0;it<maxIter;it++){
+
+	///w = K*v
+	for(int i=0;i<nn;i++)
+		w[i] = 0.0;
+	for(int e=0;e<mesh->getNe();e++){
+		for(int i=0;i<3;i++)
+			conn[i] = mesh->getElem(e)->getConn(i);
+		for(int i=0;i<3;i++){
+			if(!isFree[conn[i]])	continue;
+			for(int j=0;j<3;j++)
+				w[conn[i]] += mesh->getElem(e)->getK()[3*i+j]*v[conn[j]];
+		}
+	}
+
+	///Rayleigh quotient, w = M_l^{-1}*K*v and normalization in the M_l norm
+	double vKv = 0.0, vMv = 0.0, wMw = 0.0;
+	for(int i=0;i<nn;i++){
+		if(!isFree[i])	continue;
+		vKv += v[i]*w[i];
+		vMv += v[i]*M[i]*v[i];
+		w[i] = w[i]/M[i];
+		wMw += w[i]*M[i]*w[i];
+	}
+	if(vMv==0.0 || wMw==0.0)	break;
+	lambdaOld = lambda;
+	lambda = vKv/vMv;
+	for(int i=0;i<nn;i++)
+		v[i] = (isFree[i] ? w[i]/sqrt(wMw) : 0.0);
+	if(it>0 && fabs(lambda-lambdaOld)<tol*lambda)	break;
+    }
+
+    delete[] v;
+    delete[] w;
+    delete[] M;
+    delete[] isFree;
+    return lambda;
+}
+
+//==================================================================================================
+// setTimeStep
+//==================================================================================================
+/* Reports the stable time step, sets the time step for "dt auto" and the limit of the adaptive
+ * time step control. The Gershgorin bound is a safe but pessimistic limit. The power iteration
+ * gives a sharper value, but it approaches the limit from above, so it is only an estimate. It is
+ * used with a margin of dtMargin, and only if that is still above the Gershgorin bound.
+ */
+//==================================================================================================
+void femSolver::setTimeStep()
+{
+    const double dtMargin = 0.95;
+    double dtBound = stableTimeStep(NULL);
+    double lambda = largestEigenvalue(2000, 1e-6);
+    double dtStable = (lambda>0.0 && dtMargin*2.0/lambda>dtBound ? dtMargin*2.0/lambda : dtBound);
+    bool isExplicit = (settings->getIntegrator()=="euler");
+
+    cout<<"> Estimated stable time step of the explicit scheme: "<<dtStable<<" s (Gershgorin bound: "
+	<<dtBound<<" s)"<<endl;
+    lambdaMax = 2.0/dtStable;
+
+    if(settings->getAutoDt()){
+	settings->setDt(settings->getSafety()*dtStable);
+	cout<<"> Time step is set to: "<<settings->getDt()<<" s"<<endl;
+    }else if(isExplicit && settings->getDt()>dtStable){
+	cout<<"> Warning! Time step "<<settings->getDt()<<" s is above the estimated stability limit,"
+	    <<" the explicit solution may blow up!"<<endl;
+    }
+
+    ///The explicit scheme must stay below the stability limit
+    dtLimit = settings->getDtMax();
+    if(isExplicit && settings->getSafety()*dtStable<dtLimit)
+	dtLimit = settings->getSafety()*dtStable;
+
+    return;
+}
+
+//==================================================================================================
+// adaptTimeStep
+//==================================================================================================
+/* Adaptive time step control :
+ * change is the largest change of the temperature in the last time step. While the transient
+ * decays this change gets smaller and the time step is doubled once it is below half of the
+ * target adaptTol (up to dtLimit). If it exceeds twice the target the time step is halved.
+ * Changing only by factors of two keeps the number of operator rebuilds small.
+ */
+//==================================================================================================
+double femSolver::adaptTimeStep(double dt, double change)
+{
+    double target = settings->getAdaptTol();
+
+    if(change>2.0*target)
+	return 0.5*dt;
+    if(change<0.5*target && 2.0*dt<=dtLimit)
+	return 2.0*dt;
+
+    return dt;
+}
+
+//==================================================================================================
+// globalAssembly
+//==================================================================================================
+/* Assembly procedure :
+ * 1- The sparsity pattern of the global stiffness matrix is built from the element connectivity.
+ * 2- Element stiffness matrices (already modified by applyBoundaryConditions) are scattered into
+ *    the global matrix. Rows of Dirichlet nodes are skipped since those nodes are never solved for.
+ * 3- Lumped mass and the source + boundary vector F + B are assembled for all nodes.
+ */
+//==================================================================================================
+void femSolver::globalAssembly()
+{
+    int conn[3];
+    int nn = mesh->getNn();
+
+    delete K;
+    delete[] Ml;
+    delete[] FB;
+    K = new csrMatrix;
+    Ml = new double [nn]();
+    FB = new double [nn]();
+
+    K->buildPattern(mesh);
+
+    for(int e=0;e<mesh->getNe();e++){
+
+	for(int i=0;i<3;i++)
+		conn[i] = mesh->getElem(e)->getConn(i);
+
+	for(int i=0;i<3;i++){
+		Ml[conn[i]] = Ml[conn[i]] + mesh->getElem(e)->getM()[i];
+		FB[conn[i]] = FB[conn[i]] + mesh->getElem(e)->getF()[i] + mesh->getElem(e)->getB()[i];
+
+		if(mesh->getNode(conn[i])->getBC_type()==1)	continue;
+
+		for(int j=0;j<3;j++)
+			K->addValue(conn[i], conn[j], mesh->getElem(e)->getK()[3*i+j]);
+	}
+    }
+
+    cout<<"> Global stiffness matrix assembled: "<<nn<<" rows, "<<K->getNnz()<<" entries"<<endl;
+    return;
+}
+
+//==================================================================================================
+// explicitAssembledSolver
+//==================================================================================================
+/* Forward Euler with an assembled operator :
+ * Since K, M_l, F and B do not change after the boundary conditions are applied, the update
+ *		T_new = T + dt*M_l^{-1}*(F + B - K*T)
+ * is written once as T_new = A*T + c with
+ *		A = M_l^{-1}*(M_l - dt*K),	c = dt*M_l^{-1}*(F + B).
+ * Rows of Dirichlet nodes are identity rows with c = 0, so those nodes keep their values.
+ * Each time step is then a single sparse mat-vec with the addition of c.
+ */
+//==================================================================================================
+void femSolver::explicitAssembledSolver()
+{
+    int nn = mesh->getNn();
+    double time = 0.0;
+    double dt = settings->getDt();
+
+    ///Build the explicit operator A and the constant vector c
+    csrMatrix* A = new csrMatrix;
+    double* c = new double [nn]();
+    buildExplicitOperator(dt, A, c);
+    sellMatrix* S = buildSell(A);
+
+    ///Contiguous temperature vectors for the old and new time level
+    double* T = new double [nn];
+    double* T_new = new double [nn];
+    double* swap;
+    for(int node=0;node<nn;node++)
+	T[node] = mesh->getNode(node)->getT();
+
+    ///Time loop start
+    for(int t=0;t<=settings->getNIter();t++){
+
+	///Write solution at certain time steps
+	if(t%settings->getDwf()==0)	writeSolution(t, time, T);
+
+	///T_new = A*T + c
+	if(S!=NULL)
+		S->multiplyAdd(T, c, T_new);
+	else
+		A->multiplyAdd(T, c, T_new);
+
+	///Check if the solution reached steady state
+	double max_rate = 0.0, T_max = 0;
+	#pragma omp parallel for reduction(max:max_rate,T_max)
+	for(int node=0;node<nn;node++){
+		double rate = fabs((T_new[node] - T[node])/dt);
+		if(rate>max_rate)	max_rate = rate;
+		if(T_new[node]>T_max)	T_max = T_new[node];
+	}
+
+	swap = T; T = T_new; T_new = swap;
+
+	if(max_rate<0.001){
+		cout<<">> Solution reached Steady state! \n"<<endl;
+		cout<<"> Maximum temperature in the domain: "<<T_max<<" K\ttime = "<<time<<" s\n"<<endl;
+		break;
+	}
+
+	///Increase time by dt
+	time += dt;
+
+	///Adapt the time step to the change of the solution, A and c depend on it
+	if(settings->getAdapt()=="yes"){
+		double dtNew = adaptTimeStep(dt, max_rate*dt);
+		if(dtNew!=dt){
+			dt = dtNew;
+			buildExplicitOperator(dt, A, c);
+			if(S!=NULL)
+				S->build(A, settings->getSellSigma());
+		}
+	}
+
+    }///Time loop end
+
+    ///Copy the final field back to the mesh
+    for(int node=0;node<nn;node++)
+	mesh->getNode(node)->setT(T[node]);
+
+    delete S;
+    delete A;
+    delete[] c;
+    delete[] T;
+    delete[] T_new;
+    return;
+}
+
+//==================================================================================================
+// explicitBlockedSolver
+//==================================================================================================
+/* Forward Euler with the assembled operator and temporal blocking :
+ * The update T_new = A*T + c of explicitAssembledSolver() is applied k = tblock times per sweep
+ * through the mesh. The rows are cut into tiles whose data (rows of the tile and of a halo of k
+ * levels) fits in tileKB of cache, and every tile advances k steps before the next tile is
+ * loaded (tiledOperator). The operator is read from memory once per k steps instead of every
+ * step, at the cost of recomputing the halo rows.
+ * A block is shortened so that it ends at every output step and at the last step. Steady state
+ * is checked with the change of the last step of a block, so a run may stop up to k-1 steps later
+ * than the unblocked solver.
+ */
+//==================================================================================================
+void femSolver::explicitBlockedSolver()
+{
+    int nn = mesh->getNn();
+    int k = settings->getTBlock();
+    double time = 0.0;
+    double dt = settings->getDt();
+
+    ///Build the explicit operator A and the constant vector c
+    csrMatrix* A = new csrMatrix;
+    double* c = new double [nn]();
+    buildExplicitOperator(dt, A, c);
+
+    ///Rows per tile: the entries of a row and three node values have to fit in the cache
+    double rowBytes = (double)A->getNnz()/nn*(sizeof(int) + sizeof(double)) + 3*sizeof(double);
+    int tileRows = max(1, (int)(settings->getTileKB()*1024.0/rowBytes));
+
+    tiledOperator* tiles = new tiledOperator;
+    tiles->build(A, c, k, tileRows);
+    cout<<"> Temporal blocking: "<<tiles->getNTiles()<<" tiles of "<<tileRows<<" rows, "<<k
+	<<" steps per sweep, "<<100.0*((double)tiles->getNRows(k-1)/nn - 1.0)
+	<<" % redundant rows in the first step"<<endl;
+
+    ///Contiguous temperature vectors for the old and new time level
+    double* T = new double [nn];
+    double* T_new = new double [nn];
+    double* swap;
+    for(int node=0;node<nn;node++)
+	T[node] = mesh->getNode(node)->getT();
+
+    ///Time loop start
+    int t = 0;
+    while(t<=settings->getNIter()){
+
+	///Write solution at certain time steps
+	if(t%settings->getDwf()==0)	writeSolution(t, time, T);
+
+	///Steps of this block: up to k, ending at the next output step and the last step
+	int steps = min(k, settings->getDwf() - t%settings->getDwf());
+	steps = min(steps, settings->getNIter() + 1 - t);
+
+	double maxDelta, T_max;
+	tiles->advance(T, T_new, steps, maxDelta, T_max);
+	double max_rate = maxDelta/dt;
+	swap = T; T = T_new; T_new = swap;
+
+	time += (steps-1)*dt;
+	if(max_rate<0.001){
+		cout<<">> Solution reached Steady state! \n"<<endl;
+		cout<<"> Maximum temperature in the domain: "<<T_max<<" K\ttime = "<<time<<" s\n"<<endl;
+		break;
+	}
+
+	///Increase time by dt
+	time += dt;
+	t += steps;
+
+	///Adapt the time step to the change of the solution, A, c and the tiles depend on it
+	if(settings->getAdapt()=="yes"){
+		double dtNew = adaptTimeStep(dt, maxDelta);
+		if(dtNew!=dt){
+			dt = dtNew;
+			buildExplicitOperator(dt, A, c);
+			tiles->build(A, c, k, tileRows);
+		}
+	}
+
+    }///Time loop end
+
+    ///Copy the final field back to the mesh
+    for(int node=0;node<nn;node++)
+	mesh->getNode(node)->setT(T[node]);
+
+    delete tiles;
+    delete A;
+    delete[] c;
+    delete[] T;
+    delete[] T_new;
+    return;
+}
+
+//==================================================================================================
+// explicitEdgeSolver
+//==================================================================================================
+/* Forward Euler with the edge based operator :
+ * The assembled K is converted to one weight per unique edge and a diagonal part per node
+ * (edgeOperator), then dropped. With R_i = sum_j w_ij*(T_j - T_i) from the edge loop, the update
+ * of a node is
+ *		T_new = T + dt*M_l^{-1}*(F + B) + dt*M_l^{-1}*(R - d*T)
+ * done in one node sweep as in explicitSolver(). Each edge is read once per time step, instead of
+ * the 3x3 matrix of each element, which is about 3 times less operator data.
+ */
+//==================================================================================================
+void femSolver::explicitEdgeSolver()
+{
+    int nn = mesh->getNn();
+    int ne = mesh->getNe();
+    double time = 0.0;
+    double dt = settings->getDt();
+
+    ///Edge list, the assembled matrix is not needed any more
+    edgeOperator* E = new edgeOperator;
+    E->build(K, mesh);
+    if(settings->getNThreads()>1)
+	E->colourEdges();
+    delete K;
+    K = NULL;
+
+    int nEdges = E->getNEdges();
+    int nColours = E->getNColours();
+    int* colourPtr = E->getColourPtr();
+    int* edge0 = E->getEdge(0);
+    int* edge1 = E->getEdge(1);
+    double* w = E->getW();
+    double* d = E->getD();
+
+    double edgeBytes = nEdges*(2*sizeof(int) + sizeof(double)) + nn*sizeof(double);
+    double elemBytes = ne*(3*sizeof(int) + 9*sizeof(double));
+    cout<<"> Edge operator: "<<nEdges<<" edges, "<<edgeBytes/1048576.0<<" MB ("
+	<<elemBytes/edgeBytes<<" times less than the element matrices)"<<endl;
+
+    ///Node level variables
+    double* T = new double [nn];
+    double* dtInvM = new double [nn];
+    double* dtFB = new double [nn];
+    double* R = new double [nn]();
+    for(int node=0;node<nn;node++){
+	T[node] = mesh->getNode(node)->getT();
+	bool fixed = (mesh->getNode(node)->getBC_type()==1);
+	dtFB[node] = (!fixed ? dt*FB[node]/Ml[node] : 0.0);
+	dtInvM[node] = (!fixed ? dt/Ml[node] : 0.0);
+    }
+
+    ///Time loop start
+    for(int t=0;t<=settings->getNIter();t++){
+
+	///Write solution at certain time steps
+	if(t%settings->getDwf()==0)	writeSolution(t, time, T);
+
+	double max_rate = 0.0, T_max = 0;
+
+	#pragma omp parallel
+	{
+		///Loop through all edges, colour by colour
+		for(int c=0;c<nColours;c++){
+			#pragma omp for
+			for(int k=colourPtr[c];k<colourPtr[c+1];k++){
+				int i = edge0[k], j = edge1[k];
+				double flux = w[k]*(T[j] - T[i]);
+				R[i] += flux;
+				R[j] -= flux;
+			}
+		}///edge loop end
+
+		///Loop through all nodes, calculate and set the temperature
+		#pragma omp for reduction(max:max_rate,T_max)
+		for(int node=0;node<nn;node++){
+			double dT = dtFB[node] + dtInvM[node]*(R[node] - d[node]*T[node]);
+			R[node] = 0.0;
+			T[node] += dT;
+
+			double rate = fabs(dT/dt);
+			if(rate>max_rate)	max_rate = rate;
+			if(T[node]>T_max)	T_max = T[node];
+		}
+	}
+
+	if(max_rate<0.001){
+		cout<<">> Solution reached Steady state! \n"<<endl;
+		cout<<"> Maximum temperature in the domain: "<<T_max<<" K\ttime = "<<time<<" s\n"<<endl;
+		break;
+	}
+
+	///Increase time by dt
+	time += dt;
+
+	///Adapt the time step to the change of the solution, the node coefficients scale with dt
+	if(settings->getAdapt()=="yes"){
+		double dtNew = adaptTimeStep(dt, max_rate*dt);
+		if(dtNew!=dt){
+			for(int node=0;node<nn;node++){
+				dtInvM[node] *= dtNew/dt;
+				dtFB[node] *= dtNew/dt;
+			}
+			dt = dtNew;
+		}
+	}
+
+    }///Time loop end
+
+    ///Copy the final field back to the mesh
+    for(int node=0;node<nn;node++)
+	mesh->getNode(node)->setT(T[node]);
+
+    delete E;
+    delete[] T;
+    delete[] dtInvM;
+    delete[] dtFB;
+    delete[] R;
+    return;
+}
+
+//==================================================================================================
+// explicitMatrixFreeSolver
+//==================================================================================================
+/* Forward Euler without stored element matrices :
+ * The time loop reads only the connectivity and the node coordinates. The stiffness action of
+ * every element is recomputed from the three node coordinates in each time step with the exact P1
+ * kernel (elementKernel<triP1, exactRule>::applyK), which is a few flops per element against the
+ * 9 stored entries of K. The boundary conditions enter as
+ * - Dirichlet: dtInvM = dtFB = 0 on the fixed nodes, so their rows are not needed,
+ * - Neumann and Robin fluxes: in dtFB (from the element B vectors),
+ * - Robin heat transfer: a list of Robin faces (a, b, c = HTC*L/(6*rho*cp)), whose term
+ *   c*[2 1; 1 2] is applied after the element loop.
+ * The node sweep is the same as in explicitSolver(). Once the node coefficients and the Robin faces
+ * are set up, the element matrices of the mesh are released (triMesh::freeElementData), so for the
+ * time loop the mesh keeps only the connectivity, face groups and node data.
+ */
+//==================================================================================================
+void femSolver::explicitMatrixFreeSolver()
+{
+    ///Structure-of-arrays mesh data (connectivity and coordinates only)
+    int nn = soa->getNn();
+    int ne = soa->getNe();
+    int nColours = soa->getNColours();
+    int* colourPtr = soa->getColourPtr();
+    int* conn0 = soa->getConn(0);
+    int* conn1 = soa->getConn(1);
+    int* conn2 = soa->getConn(2);
+    double* XY = soa->getXY();
+    double* T = soa->getT();
+    int* BC_type = soa->getBC_type();
+
+    double k = settings->getD();
+    double rhoCp = settings->getRho()*settings->getCp();
+    double time = 0.0;
+    double dt = settings->getDt();
+
+    ///Node level variables
+    double* dtInvM = new double [nn]();
+    double* dtFB = new double [nn]();
+    double* R = new double [nn]();
+
+    for(int e=0;e<ne;e++){
+	triElement* elem = mesh->getElem(e);
+	for(int i=0;i<3;i++){
+		dtInvM[elem->getConn(i)] += elem->getM()[i];
+		dtFB[elem->getConn(i)] += elem->getF()[i] + elem->getB()[i];
+	}
+    }
+    for(int node=0;node<nn;node++){
+	dtFB[node] = (BC_type[node]!=1 ? dt*dtFB[node]/dtInvM[node] : 0.0);
+	dtInvM[node] = (BC_type[node]!=1 ? dt/dtInvM[node] : 0.0);
+    }
+
+    ///Robin faces
+    int nRobin = 0;
+    for(int e=0;e<ne;e++)
+	for(int i=0;i<3;i++)
+		if(mesh->getElem(e)->getFG(i)!=0 &&
+		   settings->getBC(mesh->getElem(e)->getFG(i))->getType()==3)	nRobin++;
+
+    int* robin0 = new int [nRobin];
+    int* robin1 = new int [nRobin];
+    double* robinC = new double [nRobin];
+    nRobin = 0;
+    for(int e=0;e<ne;e++){
+	for(int i=0;i<3;i++){
+		int FG = mesh->getElem(e)->getFG(i);
+		if(FG==0 || settings->getBC(FG)->getType()!=3)	continue;
+		int a = mesh->getElem(e)->getConn(edgeNodes[i][0]);
+		int b = mesh->getElem(e)->getConn(edgeNodes[i][1]);
+		double dX = XY[2*a] - XY[2*b], dY = XY[2*a+1] - XY[2*b+1];
+		double L = sqrt(dX*dX + dY*dY);
+		robin0[nRobin] = a;
+		robin1[nRobin] = b;
+		robinC[nRobin++] = settings->getBC(FG)->getHTC()*L/(6.0*rhoCp);
+	}
+    }
+
+    ///The element matrices are not used any more, the time loop only needs the node coefficients,
+    ///the Robin faces and the coordinates
+    double released = (double)ne*elemDataSize*sizeof(double);
+    mesh->freeElementData();
+    cout<<"> Element matrices released: "<<released/1048576.0<<" MB"<<endl;
+
+    ///Memory traffic of one time step: element loop (connectivity) and node sweep
+    double bytes = ne*3*sizeof(int) + nn*8*sizeof(double);
+    cout<<"> Matrix-free step moves "<<bytes/nn<<" bytes per DOF update, "<<nRobin
+	<<" Robin faces"<<endl;
+
+    ///Time loop start
+    for(int t=0;t<=settings->getNIter();t++){
+
+	///Write solution at certain time steps
+	if(t%settings->getDwf()==0)	writeSolution(t, time, T);
+
+	double max_rate = 0.0, T_max = 0;
+
+	#pragma omp parallel
+	{
+		///Loop through all elements, colour by colour, and recompute -K*T. Every element is
+		///computed and scattered on its own: the gathers of the coordinates cannot be vectorized,
+		///and staging a batch of elements for the SIMD kernel cost more than it saved.
+		for(int c=0;c<nColours;c++){
+			#pragma omp for
+			for(int e=colourPtr[c];e<colourPtr[c+1];e++){
+				int c0 = conn0[e], c1 = conn1[e], c2 = conn2[e];
+				double Xe[3] = {XY[2*c0], XY[2*c1], XY[2*c2]};
+				double Ye[3] = {XY[2*c0+1], XY[2*c1+1], XY[2*c2+1]};
+				double Te[3] = {T[c0], T[c1], T[c2]};
+				double KT[3];
+
+				elementKernel<triP1, exactRule>::applyK(Xe, Ye, k, Te, KT);
+
+				R[c0] -= KT[0];
+				R[c1] -= KT[1];
+				R[c2] -= KT[2];
+			}
+		}///element loop end
+
+		///Heat transfer on the Robin faces
+		#pragma omp single
+		for(int f=0;f<nRobin;f++){
+			int a = robin0[f], b = robin1[f];
+			R[a] -= robinC[f]*(2.0*T[a] + T[b]);
+			R[b] -= robinC[f]*(T[a] + 2.0*T[b]);
+		}
+
+		///Loop through all nodes, calculate and set the temperature
+		#pragma omp for reduction(max:max_rate,T_max)
+		for(int node=0;node<nn;node++){
+			double dT = dtFB[node] + dtInvM[node]*R[node];
+			R[node] = 0.0;
+			T[node] += dT;
+
+			double rate = fabs(dT/dt);
+			if(rate>max_rate)	max_rate = rate;
+			if(T[node]>T_max)	T_max = T[node];
+		}
+	}
+
+	if(max_rate<0.001){
+		cout<<">> Solution reached Steady state! \n"<<endl;
+		cout<<"> Maximum temperature in the domain: "<<T_max<<" K\ttime = "<<time<<" s\n"<<endl;
+		break;
+	}
+
+	///Increase time by dt
+	time += dt;
+
+	///Adapt the time step to the change of the solution, the node coefficients scale with dt
+	if(settings->getAdapt()=="yes"){
+		double dtNew = adaptTimeStep(dt, max_rate*dt);
+		if(dtNew!=dt){
+			for(int node=0;node<nn;node++){
+				dtInvM[node] *= dtNew/dt;
+				dtFB[node] *= dtNew/dt;
+			}
+			dt = dtNew;
+		}
+	}
+
+    }///Time loop end
+
+    ///Copy the final field back to the mesh
+    soa->scatterT(mesh);
+
+    delete[] dtInvM;
+    delete[] dtFB;
+    delete[] R;
+    delete[] robin0;
+    delete[] robin1;
+    delete[] robinC;
+    return;
+}
+
+//==================================================================================================
+// buildSell
+// SELL-C-sigma copy of an assembled matrix if "format sell" is set, NULL for "format csr".
+//==================================================================================================
+sellMatrix* femSolver::buildSell(csrMatrix* A)
+{
+    if(settings->getFormat()=="csr")
+	return NULL;
+    if(settings->getFormat()!="sell"){
+	cout<<"Unknown matrix format : "<<settings->getFormat()<<"! Aborting..."<<endl;
+	exit(0);
+    }
+
+    sellMatrix* S = new sellMatrix;
+    S->build(A, settings->getSellSigma());
+    cout<<"> SELL-"<<sellC<<"-"<<settings->getSellSigma()<<" matrix: "<<S->getNnz()
+	<<" stored entries, padding "<<100.0*(S->getNnz()-A->getNnz())/A->getNnz()<<" %"<<endl;
+
+    return S;
+}
+
+//==================================================================================================
+// buildExplicitOperator
+// A = M_l^{-1}*(M_l - dt*K) and c = dt*M_l^{-1}*(F + B), identity rows for Dirichlet nodes.
+//==================================================================================================
+void femSolver::buildExplicitOperator(double dt, csrMatrix* A, double* c)
+{
+    int nn = mesh->getNn();
+    A->copyPattern(K);
+
+    int* rowPtr = A->getRowPtr();
+    int* col = A->getCol();
+    double* valA = A->getVal();
+    double* valK = K->getVal();
+    for(int i=0;i<nn;i++){
+	if(mesh->getNode(i)->getBC_type()==1){
+		valA[A->findEntry(i,i)] = 1.0;
+		c[i] = 0.0;
+		continue;
+	}
+	for(int k=rowPtr[i];k<rowPtr[i+1];k++)
+		valA[k] = (col[k]==i ? 1.0 : 0.0) - dt*valK[k]/Ml[i];
+	c[i] = dt*FB[i]/Ml[i];
+    }
+
+    return;
+}
+
+//==================================================================================================
+// buildSystemMatrix
+//==================================================================================================
+/* Builds A = massCoef*M_l + stiffCoef*K for the implicit and steady solvers :
+ * Rows of Dirichlet nodes only keep their diagonal, so their value is fixed by the right hand side.
+ * To keep A symmetric, the columns of Dirichlet nodes are removed from the other rows as well and
+ * their known contribution is returned in lift:
+ *		lift_i = sum_j stiffCoef*K_ij*T_j,	j on the Dirichlet boundary.
+ * lift has to be subtracted from the right hand side of every free node.
+ * The diagonal of the Dirichlet rows is set to the mean diagonal of the free rows, so that these
+ * rows do not dominate the residual norm of the linear solver. This value is returned, the right
+ * hand side of a Dirichlet node has to be set to it times the temperature of the node.
+ * Nodes that no element uses (a mesh may carry such nodes) get the same diagonal, their right hand
+ * side is zero, so every row of A has a nonzero diagonal for the preconditioners.
+ */
+//==================================================================================================
+double femSolver::buildSystemMatrix(double massCoef, double stiffCoef, csrMatrix* A, double* lift)
+{
+    int nn = mesh->getNn();
+    A->copyPattern(K);
+
+    int* rowPtr = A->getRowPtr();
+    int* col = A->getCol();
+    double* valA = A->getVal();
+    double* valK = K->getVal();
+
+    double diagSum = 0.0;
+    int nFree = 0;
+    for(int i=0;i<nn;i++){
+	lift[i] = 0.0;
+	if(mesh->getNode(i)->getBC_type()==1)	continue;
+	for(int k=rowPtr[i];k<rowPtr[i+1];k++){
+		if(mesh->getNode(col[k])->getBC_type()==1){
+			lift[i] += stiffCoef*valK[k]*mesh->getNode(col[k])->getT();
+			continue;
+		}
+		valA[k] = stiffCoef*valK[k];
+		if(col[k]==i){
+			valA[k] += massCoef*Ml[i];
+			diagSum += valA[k];
+			if(valA[k]!=0.0)	nFree++;
+		}
+	}
+    }
+
+    ///Dirichlet nodes and unused nodes get a scaled identity row
+    double dirichletDiag = (nFree>0 ? diagSum/nFree : 1.0);
+    for(int i=0;i<nn;i++){
+	int diag = A->findEntry(i,i);
+	if(mesh->getNode(i)->getBC_type()==1 || valA[diag]==0.0)
+		valA[diag] = dirichletDiag;
+    }
+
+    return dirichletDiag;
+}
+
+//==================================================================================================
+// implicitSolver
+//==================================================================================================
+/* Theta scheme with the lumped mass matrix :
+ *	(M_l + theta*dt*K)*T_new = (M_l - (1-theta)*dt*K)*T + dt*(F + B)
+ * theta = 1 is backward Euler, theta = 0.5 is Crank-Nicolson. The system matrix does not change,
+ * so it is built and preconditioned once and every time step is one PCG solve.
+ */
+//==================================================================================================
+void femSolver::implicitSolver()
+{
+    int nn = mesh->getNn();
+    double time = 0.0;
+    double dt = settings->getDt();
+    double theta = settings->getTheta();
+
+    ///System matrix, Dirichlet lifting and linear solver
+    csrMatrix* A = new csrMatrix;
+    double* lift = new double [nn];
+    double dirichletDiag = buildSystemMatrix(1.0, theta*dt, A, lift);
+    sellMatrix* S = buildSell(A);
+
+    preconditioner* P = createPreconditioner(settings->getPrecond());
+    P->setup(A);
+    pcgSolver* cg = new pcgSolver;
+    cg->setup(A, P, settings->getTol(), settings->getMaxIter());
+    cg->setSell(S);
+
+    ///Node level variables
+    double* T = new double [nn];
+    double* T_new = new double [nn];
+    double* b = new double [nn];
+    double* KT = new double [nn];
+    int* BC_type = new int [nn];
+    double* swap;
+    for(int node=0;node<nn;node++){
+	T[node] = mesh->getNode(node)->getT();
+	BC_type[node] = mesh->getNode(node)->getBC_type();
+    }
+
+    int iter, totalIter = 0, nSolve = 0;
+
+    ///Time loop start
+    for(int t=0;t<=settings->getNIter();t++){
+
+	///Write solution at certain time steps
+	if(t%settings->getDwf()==0){
+		writeSolution(t, time, T);
+		if(nSolve>0)
+			cout<<"> Average CG iterations per time step: "<<(double)totalIter/nSolve<<endl;
+	}
+
+	///Right hand side (M_l - (1-theta)*dt*K)*T + dt*(F + B) - lift
+	K->multiply(T, KT);
+	#pragma omp parallel for
+	for(int node=0;node<nn;node++){
+		if(BC_type[node]==1)
+			b[node] = dirichletDiag*T[node];
+		else
+			b[node] = Ml[node]*T[node] - (1.0-theta)*dt*KT[node] + dt*FB[node] - lift[node];
+		T_new[node] = T[node];
+	}
+
+	///Solve for the new temperature, the old one is the initial guess
+	iter = cg->solve(b, T_new);
+	totalIter += iter;
+	nSolve++;
+
+	///Check if the solution reached steady state
+	double max_rate = 0.0, T_max = 0;
+	#pragma omp parallel for reduction(max:max_rate,T_max)
+	for(int node=0;node<nn;node++){
+		double rate = fabs((T_new[node] - T[node])/dt);
+		if(rate>max_rate)	max_rate = rate;
+		if(T_new[node]>T_max)	T_max = T_new[node];
+	}
+
+	swap = T; T = T_new; T_new = swap;
+
+	if(max_rate<0.001){
+		cout<<">> Solution reached Steady state! \n"<<endl;
+		cout<<"> Maximum temperature in the domain: "<<T_max<<" K\ttime = "<<time<<" s\n"<<endl;
+		break;
+	}
+
+	///Increase time by dt
+	time += dt;
+
+	///Adapt the time step to the change of the solution. The system matrix and the
+	///preconditioner are rebuilt, so the time step only changes by factors of two.
+	if(settings->getAdapt()=="yes"){
+		double dtNew = adaptTimeStep(dt, max_rate*dt);
+		if(dtNew!=dt){
+			dt = dtNew;
+			dirichletDiag = buildSystemMatrix(1.0, theta*dt, A, lift);
+			if(S!=NULL)
+				S->build(A, settings->getSellSigma());
+			P->setup(A);
+			cg->setup(A, P, settings->getTol(), settings->getMaxIter());
+		}
+	}
+
+    }///Time loop end
+
+    if(nSolve>0)
+	cout<<"> Average CG iterations per time step: "<<(double)totalIter/nSolve<<endl;
+
+    ///Copy the final field back to the mesh
+    for(int node=0;node<nn;node++)
+	mesh->getNode(node)->setT(T[node]);
+
+    delete cg;
+    delete P;
+    delete S;
+    delete A;
+    delete[] lift;
+    delete[] T;
+    delete[] T_new;
+    delete[] b;
+    delete[] KT;
+    delete[] BC_type;
+    return;
+}
+
+//==================================================================================================
+// steadySolver
+//==================================================================================================
+/* Steady state is solved directly instead of marching in time :
+ *	K*T = F + B
+ * K contains the Robin modifications from applyBoundaryConditions, the Dirichlet nodes are
+ * eliminated as in the implicit solver, nodes that no element uses get an identity row with a zero
+ * right hand side. The system is solved once with PCG.
+ */
+//==================================================================================================
+void femSolver::steadySolver()
+{
+    int nn = mesh->getNn();
+
+    ///System matrix and Dirichlet lifting
+    csrMatrix* A = new csrMatrix;
+    double* lift = new double [nn];
+    double dirichletDiag = buildSystemMatrix(0.0, 1.0, A, lift);
+    sellMatrix* S = buildSell(A);
+
+    preconditioner* P = createPreconditioner(settings->getPrecond());
+    P->setup(A);
+    pcgSolver* cg = new pcgSolver;
+    cg->setup(A, P, settings->getTol(), settings->getMaxIter());
+    cg->setSell(S);
+
+    ///Right hand side F + B - lift, the initial field is the initial guess
+    double* T = new double [nn];
+    double* b = new double [nn];
+    for(int node=0;node<nn;node++){
+	T[node] = mesh->getNode(node)->getT();
+	if(mesh->getNode(node)->getBC_type()==1)
+		b[node] = dirichletDiag*T[node];
+	else
+		b[node] = FB[node] - lift[node];
+    }
+
+    ///A residual that is not below the tolerance (or NaN) is not reported as a solution
+    int iter = cg->solve(b, T);
+    if(cg->getResNorm()<settings->getTol())
+	cout<<"> Steady state solved in "<<iter<<" CG iterations, relative residual: "<<cg->getResNorm()<<endl;
+    else
+	cout<<"> Warning! Steady state not reached, relative residual: "<<cg->getResNorm()<<endl;
+
+    double T_max = 0;
+    for(int node=0;node<nn;node++)
+	if(T[node]>T_max)	T_max = T[node];
+    cout<<"> Maximum temperature in the domain: "<<T_max<<" K\n"<<endl;
+
+    ///Write the solution, this also copies the field back to the mesh
+    writeSolution(0, 0.0, T);
+
+    delete cg;
+    delete P;
+    delete S;
+    delete A;
+    delete[] lift;
+    delete[] T;
+    delete[] b;
     return;
 }
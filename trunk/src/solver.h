@@ -11,6 +11,10 @@
 
 #include "settings.h"
 #include "tri.h"
+#include "sparse.h"
+
+class postProcessor;
+class asyncWriter;
 
 /*!
  * \brief This class defines the solver control and solver member functions
@@ -22,22 +26,63 @@ class femSolver
         /// PRIVATE VARIABLES
         inputSettings*  settings;   // a local pointer for the settings
         triMesh*        mesh;       // a local pointer for the mesh
+        csrMatrix*      K;          // global stiffness matrix (with boundary conditions)
+        double*         Ml;         // global lumped mass matrix (diagonal)
+        double*         FB;         // global source and boundary flux vector (F + B)
+        triMeshSoA*     soa;        // contiguous copy of the mesh used in the time loop
+        postProcessor*  postP;      // post processor called from the time loop
+        asyncWriter*    writer;     // output thread (NULL = output is written in the time loop)
+        double          dtLimit;    // upper limit of the adaptive time step
+        double          lambdaMax;  // largest eigenvalue of M_l^{-1}*K (2/stable time step)
 
         /// PRIVATE METHODS
-        void calculateJacobian(const int);
-        void calculateElementMatrices(const int);
+        template<class Rule> void setupElements();
+        void unitElement(const double*, const double*, double*, double*, double*);
         void applyBoundaryConditions(const int);
         void globalAssembly();
-        void explicitSolver();
+        double stableTimeStep(double*);
+        double largestEigenvalue(int, double);
+        void setTimeStep();
+        double adaptTimeStep(double, double);
+        void buildExplicitOperator(double, csrMatrix*, double*);
+        sellMatrix* buildSell(csrMatrix*);
+        template<class Real> void explicitSolver();
+        void precisionCheck();
+        void explicitEnsembleSolver();
+        void explicitSweepSolver();
+        double sweepBound(csrMatrix*, const double*);
+        void explicitAssembledSolver();
+        void explicitBlockedSolver();
+        void explicitEdgeSolver();
+        void explicitMatrixFreeSolver();
+        void elementRate(const double*, const double*, double*);
+        int  rkcStages(double);
+        void rkcCoefficients(int, double*, double*, double*, double*);
+        void rkcSolver();
+        void ltsSolver();
+        double buildSystemMatrix(double, double, csrMatrix*, double*);
+        void implicitSolver();
+        void steadySolver();
+        void writeSolution(int, double, double*);
 
     protected:
 
     public:
         /// DEFAULT CONSTRUCTOR
-        femSolver(){};
+        femSolver()
+        {
+            K=NULL; Ml=NULL; FB=NULL; soa=NULL; postP=NULL; writer=NULL;
+            dtLimit=0.0; lambdaMax=0.0;
+        };
 
         /// DESTRUCTOR
-        ~femSolver(){};
+        ~femSolver()
+        {
+            delete K;
+            delete[] Ml;
+            delete[] FB;
+            delete soa;
+        };
 
         /// INTERFACE FUNCTION
         void solverControl(inputSettings*, triMesh*);
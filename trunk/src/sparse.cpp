@@ -0,0 +1,722 @@
+//==================================================================================================
+// Name        : sparse.cpp
+// Author      :
+// Version     : 1.0
+// Copyright   : See the copyright notice in the README file.
+// Description : This file contains the routines for building and applying global sparse matrices.
+//==================================================================================================
+
+#include "sparse.h"
+
+#include <algorithm>
+
+//==================================================================================================
+// void csrMatrix::buildPattern()
+//==================================================================================================
+/* Pattern build procedure :
+ * 1- Every element adds nen entries to the rows of each of its nodes, so the number of element
+ *    incidences of a node plus one for the diagonal gives an upper bound for the length of its row.
+ * 2- The column indices are collected in these over-allocated rows. Every row starts with its
+ *    diagonal, so nodes that no element uses still get a (zero) diagonal entry.
+ * 3- Each row is sorted and the duplicate entries (edges shared by two elements) are removed.
+ * 4- Rows are compacted into the final CSR arrays and the values are set to zero.
+ */
+//==================================================================================================
+void csrMatrix::buildPattern(triMesh* mesh)
+{
+    int ne = mesh->getNe();
+    nRows = mesh->getNn();
+    nCols = nRows;
+
+    ///Upper bound for the length of each row
+    int* bound = new int [nRows+1]();
+    for(int e=0;e<ne;e++)
+	for(int i=0;i<nen;i++)
+		bound[mesh->getElem(e)->getConn(i)+1] += nen;
+    for(int i=0;i<nRows;i++)
+	bound[i+1] += bound[i] + 1;
+
+    ///Collect the columns of every row, starting with the diagonal
+    int* fill = new int [nRows]();
+    int* tmpCol = new int [bound[nRows]];
+    for(int i=0;i<nRows;i++)
+	tmpCol[bound[i] + fill[i]++] = i;
+    int conn[nen];
+    for(int e=0;e<ne;e++){
+	for(int i=0;i<nen;i++)
+		conn[i] = mesh->getElem(e)->getConn(i);
+	for(int i=0;i<nen;i++)
+		for(int j=0;j<nen;j++)
+			tmpCol[bound[conn[i]] + fill[conn[i]]++] = conn[j];
+    }
+
+    ///Sort and remove duplicates row by row
+    delete[] rowPtr;
+    rowPtr = new int [nRows+1];
+    rowPtr[0] = 0;
+    for(int i=0;i<nRows;i++){
+	int* first = tmpCol + bound[i];
+	std::sort(first, first + fill[i]);
+	fill[i] = std::unique(first, first + fill[i]) - first;
+	rowPtr[i+1] = rowPtr[i] + fill[i];
+    }
+
+    nnz = rowPtr[nRows];
+    delete[] col;
+    delete[] val;
+    col = new int [nnz];
+    val = new double [nnz]();
+    for(int i=0;i<nRows;i++)
+	std::memcpy(col+rowPtr[i], tmpCol+bound[i], fill[i]*sizeof(int));
+
+    delete[] bound;
+    delete[] fill;
+    delete[] tmpCol;
+    return;
+}
+
+//==================================================================================================
+// void csrMatrix::copyPattern()
+// Takes over the sparsity pattern of another matrix, values are set to zero.
+//==================================================================================================
+void csrMatrix::copyPattern(csrMatrix* other)
+{
+    nRows = other->getNRows();
+    nCols = other->getNCols();
+    nnz = other->getNnz();
+
+    delete[] rowPtr;
+    delete[] col;
+    delete[] val;
+    rowPtr = new int [nRows+1];
+    col = new int [nnz];
+    val = new double [nnz]();
+    std::memcpy(rowPtr, other->getRowPtr(), (nRows+1)*sizeof(int));
+    std::memcpy(col, other->getCol(), nnz*sizeof(int));
+
+    return;
+}
+
+//==================================================================================================
+// void csrMatrix::setData()
+// Takes over CSR arrays that were allocated with new[] by the caller.
+//==================================================================================================
+void csrMatrix::setData(int argNRows, int argNCols, int* argRowPtr, int* argCol, double* argVal)
+{
+    delete[] rowPtr;
+    delete[] col;
+    delete[] val;
+
+    nRows = argNRows;
+    nCols = argNCols;
+    rowPtr = argRowPtr;
+    col = argCol;
+    val = argVal;
+    nnz = rowPtr[nRows];
+
+    return;
+}
+
+//==================================================================================================
+// void csrMatrix::zero()
+//==================================================================================================
+void csrMatrix::zero()
+{
+    for(int k=0;k<nnz;k++)
+	val[k] = 0.0;
+
+    return;
+}
+
+//==================================================================================================
+// int csrMatrix::findEntry()
+// Returns the position of entry (i,j) in col and val, or -1 if it is not in the pattern.
+//==================================================================================================
+int csrMatrix::findEntry(int i, int j)
+{
+    int* first = col + rowPtr[i];
+    int* last = col + rowPtr[i+1];
+    int* pos = std::lower_bound(first, last, j);
+
+    if(pos==last || *pos!=j)
+	return -1;
+
+    return pos - col;
+}
+
+//==================================================================================================
+// void csrMatrix::addValue()
+//==================================================================================================
+void csrMatrix::addValue(int i, int j, double value)
+{
+    int k = findEntry(i, j);
+    if(k<0){
+	cout << "Entry (" << i << "," << j << ") is not in the sparsity pattern! Aborting..." << endl;
+	exit(0);
+    }
+    val[k] += value;
+
+    return;
+}
+
+//==================================================================================================
+// void csrMatrix::multiply()
+// y = A*x
+//==================================================================================================
+void csrMatrix::multiply(const double* x, double* y)
+{
+    #pragma omp parallel for
+    for(int i=0;i<nRows;i++){
+	double sum = 0.0;
+	for(int k=rowPtr[i];k<rowPtr[i+1];k++)
+		sum += val[k]*x[col[k]];
+	y[i] = sum;
+    }
+
+    return;
+}
+
+//==================================================================================================
+// void csrMatrix::multiplyAdd()
+// y = A*x + b. The addition of b is done in the same sweep as the mat-vec product.
+//==================================================================================================
+void csrMatrix::multiplyAdd(const double* x, const double* b, double* y)
+{
+    #pragma omp parallel for
+    for(int i=0;i<nRows;i++){
+	double sum = b[i];
+	for(int k=rowPtr[i];k<rowPtr[i+1];k++)
+		sum += val[k]*x[col[k]];
+	y[i] = sum;
+    }
+
+    return;
+}
+
+//==================================================================================================
+// csrMatrix* csrMatrix::transpose()
+// Returns a new matrix A^T, its rows are sorted since the rows of A are visited in order.
+//==================================================================================================
+csrMatrix* csrMatrix::transpose()
+{
+    int* tRowPtr = new int [nCols+1]();
+    int* tCol = new int [nnz];
+    double* tVal = new double [nnz];
+
+    for(int k=0;k<nnz;k++)
+	tRowPtr[col[k]+1]++;
+    for(int j=0;j<nCols;j++)
+	tRowPtr[j+1] += tRowPtr[j];
+
+    int* fill = new int [nCols];
+    std::memcpy(fill, tRowPtr, nCols*sizeof(int));
+    for(int i=0;i<nRows;i++){
+	for(int k=rowPtr[i];k<rowPtr[i+1];k++){
+		tCol[fill[col[k]]] = i;
+		tVal[fill[col[k]]++] = val[k];
+	}
+    }
+    delete[] fill;
+
+    csrMatrix* T = new csrMatrix;
+    T->setData(nCols, nRows, tRowPtr, tCol, tVal);
+    return T;
+}
+
+//==================================================================================================
+// csrMatrix* csrMatrix::multiplyMatrix()
+//==================================================================================================
+/* Returns a new matrix C = A*B :
+ * 1- Symbolic pass: the columns of every row of C are counted with a marker array over the
+ *    columns of B.
+ * 2- Numeric pass: the products are accumulated in a dense row buffer, the columns of each row are
+ *    sorted afterwards.
+ */
+//==================================================================================================
+csrMatrix* csrMatrix::multiplyMatrix(csrMatrix* B)
+{
+    int nc = B->getNCols();
+    int* bRowPtr = B->getRowPtr();
+    int* bCol = B->getCol();
+    double* bVal = B->getVal();
+
+    int* marker = new int [nc];
+    for(int j=0;j<nc;j++)
+	marker[j] = -1;
+
+    ///Symbolic pass
+    int* cRowPtr = new int [nRows+1];
+    cRowPtr[0] = 0;
+    for(int i=0;i<nRows;i++){
+	int count = 0;
+	for(int k=rowPtr[i];k<rowPtr[i+1];k++){
+		for(int l=bRowPtr[col[k]];l<bRowPtr[col[k]+1];l++){
+			if(marker[bCol[l]]!=i){
+				marker[bCol[l]] = i;
+				count++;
+			}
+		}
+	}
+	cRowPtr[i+1] = cRowPtr[i] + count;
+    }
+
+    ///Numeric pass
+    int* cCol = new int [cRowPtr[nRows]];
+    double* cVal = new double [cRowPtr[nRows]];
+    double* row = new double [nc]();
+    for(int j=0;j<nc;j++)
+	marker[j] = -1;
+
+    for(int i=0;i<nRows;i++){
+	int pos = cRowPtr[i];
+	for(int k=rowPtr[i];k<rowPtr[i+1];k++){
+		for(int l=bRowPtr[col[k]];l<bRowPtr[col[k]+1];l++){
+			if(marker[bCol[l]]!=i){
+				marker[bCol[l]] = i;
+				cCol[pos++] = bCol[l];
+			}
+			row[bCol[l]] += val[k]*bVal[l];
+		}
+	}
+	std::sort(cCol+cRowPtr[i], cCol+cRowPtr[i+1]);
+	for(int k=cRowPtr[i];k<cRowPtr[i+1];k++){
+		cVal[k] = row[cCol[k]];
+		row[cCol[k]] = 0.0;
+	}
+    }
+
+    delete[] marker;
+    delete[] row;
+
+    csrMatrix* C = new csrMatrix;
+    C->setData(nRows, nc, cRowPtr, cCol, cVal);
+    return C;
+}
+
+//==================================================================================================
+// void sellMatrix::build()
+//==================================================================================================
+/* Conversion from CSR :
+ * 1- The rows of every window of argSigma rows are sorted by decreasing length (stable), which
+ *    gives the slot order perm[].
+ * 2- The length of a chunk is the length of its first (longest) row, chunkPtr is the running sum
+ *    of sellC*chunkLen.
+ * 3- Entry j of the row in slot r of chunk c is stored at chunkPtr[c] + j*sellC + r, the rest of
+ *    the chunk is padded with zeros.
+ */
+//==================================================================================================
+void sellMatrix::build(csrMatrix* A, int argSigma)
+{
+    int* rowPtr = A->getRowPtr();
+    int* csrCol = A->getCol();
+    double* csrVal = A->getVal();
+
+    nRows = A->getNRows();
+    sigma = (argSigma>sellC ? argSigma : sellC);
+    nChunks = (nRows + sellC - 1)/sellC;
+
+    delete[] chunkPtr;
+    delete[] chunkLen;
+    delete[] perm;
+    delete[] col;
+    delete[] val;
+
+    ///Slot order: rows sorted by decreasing length within each window
+    perm = new int [nChunks*sellC];
+    pair<int,int>* key = new pair<int,int> [nRows];
+    for(int i=0;i<nRows;i++)
+	key[i] = make_pair(-(rowPtr[i+1]-rowPtr[i]), i);
+    for(int w=0;w<nRows;w+=sigma)
+	std::stable_sort(key+w, key+min(w+sigma, nRows));
+    for(int k=0;k<nChunks*sellC;k++)
+	perm[k] = (k<nRows ? key[k].second : -1);
+    delete[] key;
+
+    ///Padded length and start of every chunk
+    chunkLen = new int [nChunks];
+    chunkPtr = new int [nChunks+1];
+    chunkPtr[0] = 0;
+    for(int c=0;c<nChunks;c++){
+	chunkLen[c] = 0;
+	for(int r=0;r<sellC;r++){
+		int i = perm[c*sellC+r];
+		if(i>=0 && rowPtr[i+1]-rowPtr[i]>chunkLen[c])
+			chunkLen[c] = rowPtr[i+1]-rowPtr[i];
+	}
+	chunkPtr[c+1] = chunkPtr[c] + sellC*chunkLen[c];
+    }
+
+    ///Column by column storage of each chunk
+    col = new int [chunkPtr[nChunks]]();
+    val = new double [chunkPtr[nChunks]]();
+    for(int c=0;c<nChunks;c++){
+	for(int r=0;r<sellC;r++){
+		int i = perm[c*sellC+r];
+		if(i<0)	continue;
+		for(int k=rowPtr[i];k<rowPtr[i+1];k++){
+			col[chunkPtr[c] + (k-rowPtr[i])*sellC + r] = csrCol[k];
+			val[chunkPtr[c] + (k-rowPtr[i])*sellC + r] = csrVal[k];
+		}
+	}
+    }
+
+    return;
+}
+
+//==================================================================================================
+// void sellMatrix::multiply()
+// y = A*x, the sellC rows of a chunk are summed in SIMD lanes.
+//==================================================================================================
+void sellMatrix::multiply(const double* x, double* y)
+{
+    #pragma omp parallel for schedule(static)
+    for(int c=0;c<nChunks;c++){
+	double sum[sellC];
+	const int* cc = col + chunkPtr[c];
+	const double* vv = val + chunkPtr[c];
+
+	for(int r=0;r<sellC;r++)
+		sum[r] = 0.0;
+	for(int j=0;j<chunkLen[c];j++){
+		#pragma omp simd
+		for(int r=0;r<sellC;r++)
+			sum[r] += vv[j*sellC+r]*x[cc[j*sellC+r]];
+	}
+	for(int r=0;r<sellC;r++)
+		if(perm[c*sellC+r]>=0)
+			y[perm[c*sellC+r]] = sum[r];
+    }
+
+    return;
+}
+
+//==================================================================================================
+// void sellMatrix::multiplyAdd()
+// y = A*x + b. The addition of b is done in the same sweep as the mat-vec product.
+//==================================================================================================
+void sellMatrix::multiplyAdd(const double* x, const double* b, double* y)
+{
+    #pragma omp parallel for schedule(static)
+    for(int c=0;c<nChunks;c++){
+	double sum[sellC];
+	const int* cc = col + chunkPtr[c];
+	const double* vv = val + chunkPtr[c];
+
+	for(int r=0;r<sellC;r++)
+		sum[r] = (perm[c*sellC+r]>=0 ? b[perm[c*sellC+r]] : 0.0);
+	for(int j=0;j<chunkLen[c];j++){
+		#pragma omp simd
+		for(int r=0;r<sellC;r++)
+			sum[r] += vv[j*sellC+r]*x[cc[j*sellC+r]];
+	}
+	for(int r=0;r<sellC;r++)
+		if(perm[c*sellC+r]>=0)
+			y[perm[c*sellC+r]] = sum[r];
+    }
+
+    return;
+}
+
+//==================================================================================================
+// void tiledOperator::build()
+//==================================================================================================
+/* Tile build procedure, for every tile of tileRows consecutive rows :
+ * 1- The rows of the tile are level 0. Level l is found by a breadth first step from level l-1 in
+ *    the graph of A, up to level argDepth. The local nodes are stored in the order of the levels.
+ * 2- The rows of the levels 0..argDepth-1 are copied with local column numbers. Their columns are
+ *    at most one level further out, so they are always local nodes.
+ * The tiles are built twice, the first pass only counts the local nodes and entries for the
+ * allocation. The global-to-local map is reset for the visited nodes only.
+ */
+//==================================================================================================
+void tiledOperator::build(csrMatrix* A, const double* argC, int argDepth, int tileRows)
+{
+    int n = A->getNRows();
+    int* aRowPtr = A->getRowPtr();
+    int* aCol = A->getCol();
+    double* aVal = A->getVal();
+
+    depth = argDepth;
+    nTiles = (n + tileRows - 1)/tileRows;
+
+    delete[] nodePtr;
+    delete[] node;
+    delete[] levelCount;
+    delete[] rowBase;
+    delete[] rowPtr;
+    delete[] col;
+    delete[] val;
+    delete[] c;
+
+    nodePtr = new int [nTiles+1];
+    levelCount = new int [nTiles*(depth+1)];
+    rowBase = new int [nTiles+1];
+
+    int* localOf = new int [n];
+    int* list = new int [n];
+    for(int i=0;i<n;i++)
+	localOf[i] = -1;
+
+    ///Pass 1 counts the local nodes and entries, pass 2 fills the arrays
+    for(int pass=1;pass<=2;pass++){
+	int entry = 0;
+	maxLocal = 0;
+	nodePtr[0] = 0;
+	rowBase[0] = 0;
+
+	for(int t=0;t<nTiles;t++){
+		int* count = levelCount + t*(depth+1);
+		int nLocal = 0;
+
+		///Level 0: the rows of the tile
+		for(int i=t*tileRows;i<min((t+1)*tileRows, n);i++){
+			localOf[i] = nLocal;
+			list[nLocal++] = i;
+		}
+		count[0] = nLocal;
+
+		///Level l: neighbours of level l-1
+		for(int l=1;l<=depth;l++){
+			for(int q=(l==1 ? 0 : count[l-2]);q<count[l-1];q++){
+				for(int k=aRowPtr[list[q]];k<aRowPtr[list[q]+1];k++){
+					if(localOf[aCol[k]]>=0)	continue;
+					localOf[aCol[k]] = nLocal;
+					list[nLocal++] = aCol[k];
+				}
+			}
+			count[l] = nLocal;
+		}
+
+		///Rows of the levels 0..depth-1 with local columns
+		int* rp = (pass==2 ? rowPtr + rowBase[t] + t : NULL);
+		for(int q=0;q<count[depth-1];q++){
+			int i = list[q];
+			if(pass==2){
+				rp[q] = entry;
+				c[rowBase[t]+q] = argC[i];
+				for(int k=aRowPtr[i];k<aRowPtr[i+1];k++){
+					col[entry + k-aRowPtr[i]] = localOf[aCol[k]];
+					val[entry + k-aRowPtr[i]] = aVal[k];
+				}
+			}
+			entry += aRowPtr[i+1] - aRowPtr[i];
+		}
+		if(pass==2){
+			rp[count[depth-1]] = entry;
+			std::memcpy(node+nodePtr[t], list, nLocal*sizeof(int));
+		}
+
+		for(int q=0;q<nLocal;q++)
+			localOf[list[q]] = -1;
+
+		nodePtr[t+1] = nodePtr[t] + nLocal;
+		rowBase[t+1] = rowBase[t] + count[depth-1];
+		maxLocal = max(maxLocal, nLocal);
+	}
+
+	if(pass==1){
+		node = new int [nodePtr[nTiles]];
+		rowPtr = new int [rowBase[nTiles]+nTiles];
+		col = new int [entry];
+		val = new double [entry];
+		c = new double [rowBase[nTiles]];
+	}
+    }
+
+    delete[] localOf;
+    delete[] list;
+    return;
+}
+
+//==================================================================================================
+// int tiledOperator::getNRows()
+// Number of rows computed over all tiles in a step that updates the levels 0..l.
+//==================================================================================================
+int tiledOperator::getNRows(int l)
+{
+    int sum = 0;
+    for(int t=0;t<nTiles;t++)
+	sum += levelCount[t*(depth+1) + l];
+
+    return sum;
+}
+
+//==================================================================================================
+// void tiledOperator::advance()
+//==================================================================================================
+/* Advances x by steps (<= depth) updates x = A*x + c, reading the start values from x0 and writing
+ * the final values to x1. maxDelta returns the largest change of the last update and xMax the
+ * largest value of x1. Each tile works on two local vectors of its own, the tiles are processed
+ * in parallel.
+ */
+//==================================================================================================
+void tiledOperator::advance(const double* x0, double* x1, int steps, double& maxDelta, double& xMax)
+{
+    double dMax = 0.0, vMax = -numeric_limits<double>::max();
+
+    #pragma omp parallel reduction(max:dMax,vMax)
+    {
+	double* bufA = new double [maxLocal];
+	double* bufB = new double [maxLocal];
+
+	#pragma omp for schedule(dynamic)
+	for(int t=0;t<nTiles;t++){
+		const int* nd = node + nodePtr[t];
+		const int* count = levelCount + t*(depth+1);
+		const int* rp = rowPtr + rowBase[t] + t;
+		const double* ct = c + rowBase[t];
+		double* x = bufA;
+		double* y = bufB;
+
+		///Load the levels needed for this number of steps
+		for(int q=0;q<count[steps];q++)
+			x[q] = x0[nd[q]];
+
+		///Every step the outermost level is dropped
+		for(int s=1;s<=steps;s++){
+			for(int i=0;i<count[steps-s];i++){
+				double sum = ct[i];
+				for(int k=rp[i];k<rp[i+1];k++)
+					sum += val[k]*x[col[k]];
+				y[i] = sum;
+			}
+			double* swap = x; x = y; y = swap;
+		}
+
+		///x holds the last step, y the one before for the rows of the tile
+		for(int i=0;i<count[0];i++){
+			x1[nd[i]] = x[i];
+			if(fabs(x[i]-y[i])>dMax)	dMax = fabs(x[i]-y[i]);
+			if(x[i]>vMax)	vMax = x[i];
+		}
+	}
+
+	delete[] bufA;
+	delete[] bufB;
+    }
+
+    maxDelta = dMax;
+    xMax = vMax;
+    return;
+}
+
+//==================================================================================================
+// void edgeOperator::build()
+//==================================================================================================
+/* Edge list build procedure :
+ * 1- The rows of free nodes of the assembled matrix are visited in order. Entry (i,j) with j != i
+ *    gives the edge weight w_ij = -K_ij, the row sum gives the diagonal part d_i.
+ * 2- Each edge is taken once: from the row of its smaller node, or from the row of the free node if
+ *    the other one is a Dirichlet node (its row is not assembled). K is symmetric between free
+ *    nodes, so both rows give the same weight.
+ * All edges belong to a single colour until colourEdges() is called.
+ */
+//==================================================================================================
+void edgeOperator::build(csrMatrix* K, triMesh* mesh)
+{
+    int* rowPtr = K->getRowPtr();
+    int* col = K->getCol();
+    double* val = K->getVal();
+
+    nn = K->getNRows();
+
+    delete[] edge[0];
+    delete[] edge[1];
+    delete[] w;
+    delete[] d;
+    delete[] colourPtr;
+
+    ///Upper bound of the number of edges
+    edge[0] = new int [K->getNnz()/2 + nn];
+    edge[1] = new int [K->getNnz()/2 + nn];
+    w = new double [K->getNnz()/2 + nn];
+    d = new double [nn]();
+
+    nEdges = 0;
+    for(int i=0;i<nn;i++){
+	if(mesh->getNode(i)->getBC_type()==1)	continue;
+	for(int k=rowPtr[i];k<rowPtr[i+1];k++){
+		d[i] += val[k];
+		if(col[k]==i)	continue;
+		if(col[k]<i && mesh->getNode(col[k])->getBC_type()!=1)	continue;
+		edge[0][nEdges] = i;
+		edge[1][nEdges] = col[k];
+		w[nEdges++] = -val[k];
+	}
+    }
+
+    nColours = 1;
+    colourPtr = new int [2];
+    colourPtr[0] = 0;
+    colourPtr[1] = nEdges;
+
+    return;
+}
+
+//==================================================================================================
+// void edgeOperator::colourEdges()
+//==================================================================================================
+/* Same greedy procedure as triMeshSoA::colourElements() : colours are created one after the
+ * other, an uncoloured edge takes the current colour if none of its two nodes is marked with it.
+ * The edge arrays are then sorted by colour.
+ */
+//==================================================================================================
+void edgeOperator::colourEdges()
+{
+    int* colour = new int [nEdges];
+    int* mark = new int [nn];
+    int* count = new int [nEdges+1]();
+    int nColoured = 0;
+
+    for(int k=0;k<nEdges;k++)
+	colour[k] = -1;
+    for(int i=0;i<nn;i++)
+	mark[i] = -1;
+
+    nColours = 0;
+    while(nColoured<nEdges){
+	for(int k=0;k<nEdges;k++){
+		if(colour[k]!=-1)	continue;
+		if(mark[edge[0][k]]==nColours || mark[edge[1][k]]==nColours)	continue;
+
+		colour[k] = nColours;
+		mark[edge[0][k]] = nColours;
+		mark[edge[1][k]] = nColours;
+		count[nColours+1]++;
+		nColoured++;
+	}
+	nColours++;
+    }
+
+    ///Start of each colour and the new position of every edge
+    delete[] colourPtr;
+    colourPtr = new int [nColours+1];
+    colourPtr[0] = 0;
+    for(int c=0;c<nColours;c++)
+	colourPtr[c+1] = colourPtr[c] + count[c+1];
+
+    int* fill = new int [nColours];
+    std::memcpy(fill, colourPtr, nColours*sizeof(int));
+    int* newEdge0 = new int [nEdges];
+    int* newEdge1 = new int [nEdges];
+    double* newW = new double [nEdges];
+    for(int k=0;k<nEdges;k++){
+	int pos = fill[colour[k]]++;
+	newEdge0[pos] = edge[0][k];
+	newEdge1[pos] = edge[1][k];
+	newW[pos] = w[k];
+    }
+
+    delete[] edge[0];
+    delete[] edge[1];
+    delete[] w;
+    edge[0] = newEdge0;
+    edge[1] = newEdge1;
+    w = newW;
+
+    delete[] colour;
+    delete[] mark;
+    delete[] count;
+    delete[] fill;
+    return;
+}
@@ -0,0 +1,245 @@
+//==================================================================================================
+// Name        : sparse.h
+// Author      :
+// Version     : 1.0
+// Copyright   : See the copyright notice in the README file.
+// Description : Compressed sparse row (CSR), SELL-C-sigma, tiled and edge based storage for
+//               global operators assembled on the mesh.
+//==================================================================================================
+
+#ifndef SPARSE_H_
+#define SPARSE_H_
+
+#include "tri.h"
+
+/*!
+ * \brief This class defines a GLOBAL SPARSE MATRIX in compressed sparse row format.
+ *
+ * The sparsity pattern is the node graph of the mesh: entry (i,j) exists if the nodes i and j
+ * belong to a common element. Column indices are sorted within each row, so the diagonal entry
+ * and any other entry of a row can be found by a binary search.
+ *
+ * Matrices that are not built on the mesh (e.g. the prolongation and coarse grid operators of the
+ * multigrid preconditioner) may be rectangular and are created with setData().
+ */
+class csrMatrix
+{
+    private:
+        /// PRIVATE VARIABLES
+        int     nRows;      // number of rows (= number of nodes)
+        int     nCols;      // number of columns
+        int     nnz;        // number of stored entries
+        int*    rowPtr;     // start of each row in col and val (size nRows+1)
+        int*    col;        // column index of each entry
+        double* val;        // value of each entry
+
+    protected:
+
+    public:
+        /// DEFAULT CONSTRUCTOR
+        csrMatrix(){nRows=0; nCols=0; nnz=0; rowPtr=NULL; col=NULL; val=NULL;};
+
+        /// DESTRUCTOR
+        ~csrMatrix()
+        {
+            delete[] rowPtr;
+            delete[] col;
+            delete[] val;
+        };
+
+        /// GETTERS
+        int     getNRows()  {return nRows;};
+        int     getNCols()  {return nCols;};
+        int     getNnz()    {return nnz;};
+        int*    getRowPtr() {return rowPtr;};
+        int*    getCol()    {return col;};
+        double* getVal()    {return val;};
+
+        /// PUBLIC INTERFACE METHODS
+        void buildPattern(triMesh*);
+        void copyPattern(csrMatrix*);
+        void setData(int, int, int*, int*, double*);
+        void zero();
+        int  findEntry(int, int);
+        void addValue(int, int, double);
+        void multiply(const double*, double*);
+        void multiplyAdd(const double*, const double*, double*);
+        csrMatrix* transpose();
+        csrMatrix* multiplyMatrix(csrMatrix*);
+};
+
+
+/*!
+ * \brief This class defines a GLOBAL SPARSE MATRIX in SELL-C-sigma (sliced ELLPACK) format.
+ *
+ * The rows are cut into chunks of sellC rows. Within a chunk all rows are padded to the length of
+ * the longest one and stored column by column, so entry j of the sellC rows of a chunk lies
+ * contiguous in memory and the mat-vec handles the rows of a chunk in SIMD lanes. To keep the
+ * padding small the rows are sorted by decreasing length within windows of sigma rows; perm[]
+ * gives the row held by each slot (-1 for the empty slots of the last chunk). The entries of a row
+ * keep the column order of the CSR matrix, so the products are summed in the same order.
+ * The matrix is a copy of a csrMatrix and is rebuilt when that one changes.
+ */
+class sellMatrix
+{
+    private:
+        /// PRIVATE VARIABLES
+        int     nRows;      // number of rows
+        int     nChunks;    // number of chunks of sellC rows
+        int     sigma;      // sorting window (rows)
+        int*    chunkPtr;   // start of each chunk in col and val (size nChunks+1)
+        int*    chunkLen;   // padded row length of each chunk
+        int*    perm;       // row of each slot (size nChunks*sellC)
+        int*    col;        // column index of each entry (0 for padding)
+        double* val;        // value of each entry (0 for padding)
+
+    protected:
+
+    public:
+        /// DEFAULT CONSTRUCTOR
+        sellMatrix()
+        {
+            nRows = 0; nChunks = 0; sigma = 1;
+            chunkPtr = NULL; chunkLen = NULL; perm = NULL; col = NULL; val = NULL;
+        };
+
+        /// DESTRUCTOR
+        ~sellMatrix()
+        {
+            delete[] chunkPtr;
+            delete[] chunkLen;
+            delete[] perm;
+            delete[] col;
+            delete[] val;
+        };
+
+        /// GETTERS
+        int     getNRows()      {return nRows;};
+        int     getNnz()        {return (nChunks>0 ? chunkPtr[nChunks] : 0);};
+
+        /// PUBLIC INTERFACE METHODS
+        void build(csrMatrix*, int);
+        void multiply(const double*, double*);
+        void multiplyAdd(const double*, const double*, double*);
+};
+
+
+/*!
+ * \brief This class defines a TILED COPY of an explicit operator for TEMPORAL BLOCKING.
+ *
+ * For the update x_new = A*x + c the rows are cut into tiles of consecutive rows. Around each tile
+ * a halo of depth levels is added: level 0 are the rows of the tile, level l the neighbours of
+ * level l-1 in the graph of A. A tile then advances steps <= depth updates on its own: step s
+ * computes the rows up to level steps-s from the values of the previous step, so after the last
+ * step the rows of the tile are exact. The halo rows are computed redundantly by the neighbouring
+ * tiles. The local data of a tile (nodes sorted by level, rows of the levels 0..depth-1 with local
+ * column numbers) is small enough to stay in cache for all steps.
+ * Tiles of consecutive rows only have thin halos if the mesh is ordered (e.g. "reorder rcm").
+ */
+class tiledOperator
+{
+    private:
+        /// PRIVATE VARIABLES
+        int     nTiles;     // number of tiles
+        int     depth;      // halo depth (maximum number of steps per call)
+        int     maxLocal;   // largest number of local nodes of a tile
+        int*    nodePtr;    // first local node of each tile in node (size nTiles+1)
+        int*    node;       // global number of each local node, sorted by level
+        int*    levelCount; // number of local nodes up to level l, [tile*(depth+1) + l]
+        int*    rowBase;    // first local row of each tile (rows of the levels 0..depth-1)
+        int*    rowPtr;     // start of each local row in col and val, [rowBase[tile] + tile + i]
+        int*    col;        // local column index of each entry
+        double* val;        // value of each entry
+        double* c;          // constant vector of each local row
+
+    protected:
+
+    public:
+        /// DEFAULT CONSTRUCTOR
+        tiledOperator()
+        {
+            nTiles = 0; depth = 0; maxLocal = 0; nodePtr = NULL; node = NULL; levelCount = NULL;
+            rowBase = NULL; rowPtr = NULL; col = NULL; val = NULL; c = NULL;
+        };
+
+        /// DESTRUCTOR
+        ~tiledOperator()
+        {
+            delete[] nodePtr;
+            delete[] node;
+            delete[] levelCount;
+            delete[] rowBase;
+            delete[] rowPtr;
+            delete[] col;
+            delete[] val;
+            delete[] c;
+        };
+
+        /// GETTERS
+        int     getNTiles()     {return nTiles;};
+        int     getNLocal()     {return nodePtr[nTiles];};
+        int     getNRows(int l);
+
+        /// PUBLIC INTERFACE METHODS
+        void build(csrMatrix*, const double*, int, int);
+        void advance(const double*, double*, int, double&, double&);
+};
+
+
+/*!
+ * \brief This class defines a GLOBAL OPERATOR stored on the EDGES of the mesh.
+ *
+ * For linear triangles K is a weighted graph Laplacian plus a diagonal part (e.g. from mixed BCs):
+ *		(K*x)_i = d_i*x_i + sum_j w_ij*(x_i - x_j),	w_ij = -K_ij,	d_i = sum_j K_ij
+ * Every unique edge (i,j) stores its two nodes and one weight, the diagonal d is one value per
+ * node. The operator is built from the assembled matrix and reproduces its rows of free nodes, the
+ * rows of Dirichlet nodes are not meaningful. Edges are grouped by colour (no two edges of a colour
+ * share a node), so the edge loop runs in parallel without write conflicts.
+ */
+class edgeOperator
+{
+    private:
+        /// PRIVATE VARIABLES
+        int     nn;         // number of nodes
+        int     nEdges;     // number of unique edges
+        int*    edge[2];    // the two nodes of each edge
+        double* w;          // weight of each edge
+        double* d;          // diagonal part of each node
+        int     nColours;   // number of edge colours
+        int*    colourPtr;  // first edge of each colour (size nColours+1)
+
+    protected:
+
+    public:
+        /// DEFAULT CONSTRUCTOR
+        edgeOperator()
+        {
+            nn = 0; nEdges = 0; edge[0] = NULL; edge[1] = NULL;
+            w = NULL; d = NULL; nColours = 0; colourPtr = NULL;
+        };
+
+        /// DESTRUCTOR
+        ~edgeOperator()
+        {
+            delete[] edge[0];
+            delete[] edge[1];
+            delete[] w;
+            delete[] d;
+            delete[] colourPtr;
+        };
+
+        /// GETTERS
+        int     getNn()             {return nn;};
+        int     getNEdges()         {return nEdges;};
+        int*    getEdge(int i)      {return edge[i];};
+        double* getW()              {return w;};
+        double* getD()              {return d;};
+        int     getNColours()       {return nColours;};
+        int*    getColourPtr()      {return colourPtr;};
+
+        /// PUBLIC INTERFACE METHODS
+        void build(csrMatrix*, triMesh*);
+        void colourEdges();
+};
+
+#endif /* SPARSE_H_ */
@@ -1,285 +1,1316 @@
-//==================================================================================================
-// Name        : tri.cpp
-// Author      : A. Emre Ongut
-// Version     : 1.3
-// Copyright   : See the copyright notice in the README file.
-// Description : This file contains the routines for triangular mesh manipulation such as reading
-//               the mesh info from file or shape functions values for triangular elements.
-//==================================================================================================
-
-#include "tri.h"
-
-//==================================================================================================
-// void triMesh::readMeshFiles()
-//==================================================================================================
-/* File read procedure :
- * 1- Name of the file to be opened is retrieved from the inputSetting obj.
- * 2- File is opened in appropriate format, this is ascii format for minf and binary format for
- *    binary mesh files.
- * 3- Read operation for minf file is straight forward. Binary files are read as size of a double or
- *    int and stored in readStream. Then swapbytes function is called to swap the bytes for the 
- *    correct endianness.
- * 4- Finally obtained data is deep-copied to the mesh data structure. 
- */
-//==================================================================================================
-void triMesh::readMeshFiles(inputSettings* settings)
-{
-    ifstream    file;           // file name obj
-    string      dummy;          // dummy string to hold names
-    char*       readStream;     // temperory var used for strings read from files
-    double      dummyDouble;    // temperory var used for double values read from files
-
-    //==============================================================================================
-    // READ THE MINF FILE
-    // This file should hold the number of elements and nodes.
-    //==============================================================================================
-    cout << "====== Mesh =====" << endl;
-    dummy = settings->getMinfFile();
-    file.open(dummy.c_str(), ios::in);
-    if (file.is_open()==false)
-    {
-        cout << "Unable to open file : " << dummy << endl;
-        exit(0);
-    }
-    file >> dummy >> ne;
-    file >> dummy >> nn;
-    cout << "> Number of mesh elements : " << ne << endl;
-    cout << "> Number of nodes : " << nn << endl;
-    cout << "> File read complete: minf" << endl;
-    file.close();
-
-    //Allocation of memeory for the mesh data structure
-    node = new triNode[nn];
-    elem = new triElement[ne];
-    ME   = new triMasterElement[nGQP];
-    ME->setupGaussQuadrature();
-    ME->evaluateShapeFunctions();
-    cout << "> Mesh data structure is created." << endl;
-
-    //==============================================================================================
-    // READ THE MXYZ FILE
-    // This file contains the node coordinates
-    //==============================================================================================
-    dummy = settings->getMxyzFile();
-    file.open(dummy.c_str(), ios::in|ios::binary|ios::ate);
-    if (file.is_open()==false)
-    {
-        cout << "Unable to open file : " << dummy << endl;
-        exit(0);
-    }
-    
-    double scaleF = settings->getScale();
-    readStream = new char [nsd*sizeof(double)];
-    file.seekg (0, ios::beg);
-    for(int i=0; i<nn; i++)
-    {
-        file.read (readStream, nsd*sizeof(double));
-        swapBytes(readStream, nsd, sizeof(double));
-        node[i].setX(*((double*)readStream)*scaleF);
-        node[i].setY(*((double*)readStream+1)*scaleF);
-    }
-    cout << "> File read complete: " << dummy << endl;
-    file.close();
-
-    //==============================================================================================
-    // READ THE MIEN FILE
-    // This file contains the element connectivity
-    //==============================================================================================
-    dummy = settings->getMienFile();
-    file.open(dummy.c_str(), ios::in|ios::binary|ios::ate);
-    if (file.is_open()==false)
-    {
-        cout << "Unable to open file : " << dummy << endl;
-        exit(0);
-    }
-    readStream = new char [nen*sizeof(int)];
-    file.seekg (0, ios::beg);
-    for(int i=0; i<ne; i++)
-    {
-        file.read (readStream, nen*sizeof(int));
-        swapBytes(readStream, nen, sizeof(int));
-        for(int j=0; j<nen; j++)
-            elem[i].setConn(j, *((int*)readStream+j)-1);
-    }
-    cout << "> File read complete: " << dummy << endl;
-    file.close();
-
-    //==============================================================================================
-    // READ THE MRNG FILE
-    // This file contains the boundry information
-    //==============================================================================================
-    dummy = settings->getMrngFile();
-    file.open(dummy.c_str(), ios::in|ios::binary|ios::ate);
-    if (file.is_open()==false)
-    {
-        cout << "Unable to open file : " << dummy << endl;
-        exit(0);
-    }
-    readStream = new char [nef*sizeof(int)];
-    file.seekg (0, ios::beg);
-    for(int i=0; i<ne; i++)
-    {
-        file.read (readStream, nef*sizeof(int));
-        swapBytes(readStream, nef, sizeof(int));
-        for(int j=0; j<nef; j++)
-            elem[i].setFG(j, *((int*)readStream+j));
-    }
-    cout << "> File read complete: " << dummy << endl;
-    file.close();
-    
-  
-    //==============================================================================================
-    // READ THE INITIAL FILE OR INITIALISE
-    // This file contains initial field distribution
-    //==============================================================================================
-    dummy = settings->getDataFile();
-    file.open(dummy.c_str(), ios::in|ios::binary|ios::ate);
-
-    int initdata = 1; 
-    if (file.is_open()==false){
-        cout << "> Initial Distribution file is not present.\n> Initializing temperature field to a constant value: " << settings->getInitT() <<" K"<< endl;
-        initdata = 0;
-    }else{
-	cout<<"> Setting temperature field from initial distribution file..."<<endl;
-	readStream = new char [sizeof(double)];
-	file.seekg (0, ios::beg);
-	for(int i=0; i<nn; i++){
-	        file.read (readStream, sizeof(double));
-        	swapBytes(readStream, 1, sizeof(double));
-        	node[i].setT(*((double*)readStream));
-	}
-	cout << "> File read complete: " << dummy << endl;
-	file.close();
-    }
-
-    if(initdata == 0){
-	dummyDouble = settings->getInitT();
-	for(int i=0; i<nn; i++)
-	        node[i].setT(dummyDouble);
-    }
-
-    return;
-}
-
-
-/* File write procedure :
- * Write data file so that it can be used for furthur processing 
- * or as initial distribution file for next simulation
- */
-void triMesh::writeDataFile(inputSettings* settings){
-    ofstream    file;           // file name obj
-    string      dummy;          // dummy string to hold names
-    char*       writeStream;    // temperory var used for strings write to files
-    double      dummyDouble;    // temperory var used for double values write to files
-
-    dummy = settings->getDataFile();
-    file.open(dummy.c_str(), ios::out|ios::binary|ios::ate);
-
-    if (file.is_open()==false){
-        cout << "Unable to open file : " << dummy << endl;
-	exit(0);
-    }
-
-    cout<<"> Writing temperature field distribution file."<<endl;
-    writeStream = new char [sizeof(double)];
-
-    for(int i=0; i<nn; i++){
-       	*((double*)writeStream) = node[i].getT();
-       	swapBytes(writeStream, 1, sizeof(double));
-	file.write (writeStream, sizeof(double));
-    }
-	
-    cout << "> File write complete: " << dummy << endl;
-    file.close();
-
-return;
-}
-
-void triMesh::swapBytes (char *array, int nelem, int elsize)
-{
-    register int sizet, sizem, i, j;
-    char *bytea, *byteb;
-    sizet = elsize;
-    sizem = sizet - 1;
-    bytea = new char [sizet];
-    byteb = new char [sizet];
-    for (i = 0; i < nelem; i++)
-    {
-        memcpy((void *)bytea, (void *)(array+i*sizet), sizet);
-        for (j = 0; j < sizet; j++) 
-            byteb[j] = bytea[sizem - j];
-        memcpy((void *)(array+i*sizet), (void *)byteb, sizet);
-    }
-    free(bytea); 
-    free(byteb);
-
-    return;
-}
-
-
-//==================================================================================================
-// GAUSS QUADRATURE POINTS AND WEIGHTS ARE SET FOR 7 POINT QUADRATURE FORMULA
-//==================================================================================================
-void triMasterElement::setupGaussQuadrature()
-{
-    this[0].point[0] = 0.333333333333333;   
-    this[0].point[1] = 0.333333333333333;
-    this[0].weight   = 0.225 / 2.0;
-    
-    this[1].point[0] = 0.059715871789770;   
-    this[1].point[1] = 0.470142064105115;
-    this[1].weight   = 0.132394152788 / 2.0;
-    
-    this[2].point[0] = 0.470142064105115;   
-    this[2].point[1] = 0.059715871789770;
-    this[2].weight   = 0.132394152788 / 2.0;
-    
-    this[3].point[0] = 0.470142064105115;   
-    this[3].point[1] = 0.470142064105115;
-    this[3].weight   = 0.132394152788 / 2.0;
-    
-    this[4].point[0] = 0.101286507323456;   
-    this[4].point[1] = 0.797426985353087;
-    this[4].weight   = 0.125939180544 / 2.0;
-    
-    this[5].point[0] = 0.101286507323456;   
-    this[5].point[1] = 0.101286507323456;
-    this[5].weight   = 0.125939180544 / 2.0;
-    
-    this[6].point[0] = 0.797426985353087;   
-    this[6].point[1] = 0.101286507323456;
-    this[6].weight   = 0.125939180544 / 2.0;
-
-    return;
-}
-
-//==================================================================================================
-// EVALUATES SHAPE FUNCTIONS FOR LINEAR TRIANGULAR ELEMENT
-//==================================================================================================
-void triMasterElement::evaluateShapeFunctions()
-{
-    double ksi;
-    double eta;
-    
-    for(int i=0; i<nGQP; i++)
-    {
-        ksi  = this[i].point[0];
-        eta  = this[i].point[1];
-
-        this[i].S[0] = 1.0-ksi-eta;
-        this[i].S[1] = ksi;
-        this[i].S[2] = eta;
-        
-        this[i].dSdKsi[0] = -1.0;
-        this[i].dSdKsi[1] =  1.0;
-        this[i].dSdKsi[2] =  0.0;
-
-        this[i].dSdEta[0] = -1.0;
-        this[i].dSdEta[1] =  0.0;
-        this[i].dSdEta[2] =  1.0;
-    }
-
-    return;
-}
-
-
+//==================================================================================================
+// Name        : tri.cpp
+// Author      : A. Emre Ongut
+// Version     : 1.3
+// Copyright   : See the copyright notice in the README file.
+// Description : This file contains the routines for triangular mesh manipulation such as reading
+//               the mesh info from file or shape functions values for triangular elements.
+//==================================================================================================
+
+#include "tri.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//==================================================================================================
+// Big-endian decoding
+// The binary mesh files are big-endian. A value is loaded from any address (memcpy, the sections
+// of a file are not aligned), its bytes are reversed with one bswap instruction and the bits are
+// taken as the native value.
+//==================================================================================================
+static inline double bigEndianDouble(const char* p)
+{
+    unsigned long long u;
+    double d;
+    memcpy(&u, p, sizeof(u));
+    u = __builtin_bswap64(u);
+    memcpy(&d, &u, sizeof(d));
+    return d;
+}
+
+static inline int bigEndianInt(const char* p)
+{
+    unsigned int u;
+    memcpy(&u, p, sizeof(u));
+    return (int)__builtin_bswap32(u);
+}
+
+//==================================================================================================
+// void triMesh::readMeshFiles()
+//==================================================================================================
+/* Mesh read procedure :
+ * 1- The mesh is read either from the mesh files minf, mxyz, mien and mrng (readBinaryFiles) or,
+ *    with "cmesh", from a compiled mesh file written by meshCompiler (readCompiledMesh).
+ * 2- The initial field is read from the data file or set to the initial value (readDataFile).
+ * 3- The mesh is reordered, unless a compiled mesh is stored in a reordered numbering already.
+ */
+//==================================================================================================
+void triMesh::readMeshFiles(inputSettings* settings)
+{
+    cout << "====== Mesh =====" << endl;
+    if(settings->getCmesh() != "none")
+        readCompiledMesh(settings);
+    else
+        readBinaryFiles(settings);
+
+    readDataFile(settings);
+
+    //==============================================================================================
+    // REORDER THE MESH
+    // Nodes and elements are renumbered for locality, the original numbering is kept for output.
+    //==============================================================================================
+    if(settings->getReorder() != "none" && origNode == NULL)
+        reorderMesh(settings->getReorder());
+
+    return;
+}
+
+//==================================================================================================
+// void triMesh::readBinaryFiles()
+//==================================================================================================
+/* File read procedure :
+ * 1- Name of the file to be opened is retrieved from the inputSetting obj.
+ * 2- The minf file is read in ascii format. The binary mesh files are mapped into memory as a
+ *    whole (mapFile), no copy of the file is made.
+ * 3- Every array is decoded in one loop from the mapped file directly into the mesh data
+ *    structure, the byte order is swapped per value with bswap (bigEndianDouble/bigEndianInt).
+ * 4- The files are unmapped and the bandwidth of the load (bytes of all files / wall time) is
+ *    reported.
+ */
+//==================================================================================================
+void triMesh::readBinaryFiles(inputSettings* settings)
+{
+    ifstream    file;           // file name obj
+    string      dummy;          // dummy string to hold names
+    const char* map;            // mapped binary file
+    size_t      mapSize;        // size of the mapped file
+    double      readBytes = 0;  // bytes of all binary files read
+
+    //==============================================================================================
+    // READ THE MINF FILE
+    // This file should hold the number of elements and nodes.
+    //==============================================================================================
+    dummy = settings->getMinfFile();
+    file.open(dummy.c_str(), ios::in);
+    if (file.is_open()==false)
+    {
+        cout << "Unable to open file : " << dummy << endl;
+        exit(0);
+    }
+    file >> dummy >> ne;
+    file >> dummy >> nn;
+    cout << "> Number of mesh elements : " << ne << endl;
+    cout << "> Number of nodes : " << nn << endl;
+    cout << "> File read complete: minf" << endl;
+    file.close();
+
+    //Allocation of memeory for the mesh data structure
+    node = new triNode[nn];
+    elem = new triElement[ne];
+    ME   = new triMasterElement[nGQP];
+    ME->setupGaussQuadrature();
+    ME->evaluateShapeFunctions();
+    cout << "> Mesh data structure is created." << endl;
+
+    double readTime = wallTime();
+
+    //==============================================================================================
+    // READ THE MXYZ FILE
+    // This file contains the node coordinates
+    //==============================================================================================
+    dummy = settings->getMxyzFile();
+    map = mapFile(dummy, (size_t)nn*nsd*sizeof(double), mapSize);
+    if (map==NULL)
+    {
+        cout << "Unable to open file : " << dummy << endl;
+        exit(0);
+    }
+
+    double scaleF = settings->getScale();
+    for(int i=0; i<nn; i++)
+    {
+        node[i].setX(bigEndianDouble(map + (2*i  )*sizeof(double))*scaleF);
+        node[i].setY(bigEndianDouble(map + (2*i+1)*sizeof(double))*scaleF);
+    }
+    unmapFile(map, mapSize);
+    readBytes += mapSize;
+    cout << "> File read complete: " << dummy << endl;
+
+    //==============================================================================================
+    // READ THE MIEN FILE
+    // This file contains the element connectivity
+    //==============================================================================================
+    dummy = settings->getMienFile();
+    map = mapFile(dummy, (size_t)ne*nen*sizeof(int), mapSize);
+    if (map==NULL)
+    {
+        cout << "Unable to open file : " << dummy << endl;
+        exit(0);
+    }
+    for(int i=0; i<ne; i++)
+        for(int j=0; j<nen; j++)
+            elem[i].setConn(j, bigEndianInt(map + (nen*i+j)*sizeof(int))-1);
+    unmapFile(map, mapSize);
+    readBytes += mapSize;
+    cout << "> File read complete: " << dummy << endl;
+
+    //==============================================================================================
+    // READ THE MRNG FILE
+    // This file contains the boundry information
+    //==============================================================================================
+    dummy = settings->getMrngFile();
+    map = mapFile(dummy, (size_t)ne*nef*sizeof(int), mapSize);
+    if (map==NULL)
+    {
+        cout << "Unable to open file : " << dummy << endl;
+        exit(0);
+    }
+    for(int i=0; i<ne; i++)
+        for(int j=0; j<nef; j++)
+            elem[i].setFG(j, bigEndianInt(map + (nef*i+j)*sizeof(int)));
+    unmapFile(map, mapSize);
+    readBytes += mapSize;
+    cout << "> File read complete: " << dummy << endl;
+
+    readTime = wallTime() - readTime;
+    cout << "> Binary mesh files read: " << readBytes/1.0e6 << " MB in " << readTime << " s ("
+         << readBytes/1.0e6/readTime << " MB/s)" << endl;
+
+    return;
+}
+
+//==================================================================================================
+// void triMesh::readDataFile()
+//==================================================================================================
+/* Reads the initial field from the data file, which is big-endian and in the original numbering
+ * of the nodes. Without a data file the field is set to the initial value of the settings.
+ */
+//==================================================================================================
+void triMesh::readDataFile(inputSettings* settings)
+{
+    size_t  mapSize;
+    string  dummy = settings->getDataFile();
+    const char* map = mapFile(dummy, (size_t)nn*sizeof(double), mapSize);
+
+    if (map==NULL){
+        cout << "> Initial Distribution file is not present.\n> Initializing temperature field to a constant value: " << settings->getInitT() <<" K"<< endl;
+	for(int i=0; i<nn; i++)
+	        node[i].setT(settings->getInitT());
+    }else{
+	cout<<"> Setting temperature field from initial distribution file..."<<endl;
+	for(int i=0; i<nn; i++)
+        	node[getNodeIndex(i)].setT(bigEndianDouble(map + i*sizeof(double)));
+	unmapFile(map, mapSize);
+	cout << "> File read complete: " << dummy << endl;
+    }
+
+    return;
+}
+
+//==================================================================================================
+// void triMesh::readCompiledMesh()
+//==================================================================================================
+/* Compiled mesh read procedure :
+ * 1- The file is mapped into memory and the header is checked (magic, version, byte order and
+ *    the size of every section).
+ * 2- The sections are in native byte order and aligned, they are read in place through typed
+ *    pointers into the mapping, no decoding is needed.
+ * 3- If the mesh was reordered when it was compiled, the numbering maps are taken over, so the
+ *    reordering is not computed again. The coordinates are rescaled if the scaling factor of the
+ *    settings differs from the one of the file.
+ */
+//==================================================================================================
+void triMesh::readCompiledMesh(inputSettings* settings)
+{
+    string  name = settings->getCmesh();
+    size_t  mapSize;
+    cmeshHeader h;
+
+    double readTime = wallTime();
+    const char* map = mapFile(name, sizeof(cmeshHeader), mapSize);
+    if (map==NULL)
+    {
+        cout << "Unable to open file : " << name << " (it is written by meshCompiler)" << endl;
+        exit(0);
+    }
+    memcpy(&h, map, sizeof(h));
+    if (memcmp(h.magic, "FEMCMESH", 8) != 0 || h.version != cmeshVersion)
+    {
+        cout << name << " is not a compiled mesh of version " << cmeshVersion << "! Aborting..." << endl;
+        exit(0);
+    }
+    if (h.byteOrder != 0x01020304)
+    {
+        cout << name << " was compiled on a machine of another byte order! Aborting..." << endl;
+        exit(0);
+    }
+
+    ne = h.ne;
+    nn = h.nn;
+    long long expected[cmeshSections] = {(long long)nn*nsd*(long long)sizeof(double),
+                                         (long long)ne*nen*(long long)sizeof(int),
+                                         (long long)ne*nef*(long long)sizeof(int),
+                                         (long long)nn*(long long)sizeof(int),
+                                         (long long)ne*(long long)sizeof(int)};
+    bool reordered = (h.offset[cmeshOrigNode] != 0 && h.offset[cmeshElemIndex] != 0);
+    for(int s=0; s<cmeshSections; s++)
+    {
+        if (s>=cmeshOrigNode && !reordered)
+            continue;
+        if (h.offset[s] == 0 || h.offset[s]%cmeshAlign != 0 || h.bytes[s] != expected[s] ||
+            h.offset[s] + h.bytes[s] > (long long)mapSize)
+        {
+            cout << name << " is truncated or corrupt (section " << s << ")! Aborting..." << endl;
+            exit(0);
+        }
+    }
+    cout << "> Number of mesh elements : " << ne << endl;
+    cout << "> Number of nodes : " << nn << endl;
+
+    //Allocation of memeory for the mesh data structure
+    node = new triNode[nn];
+    elem = new triElement[ne];
+    ME   = new triMasterElement[nGQP];
+    ME->setupGaussQuadrature();
+    ME->evaluateShapeFunctions();
+    cout << "> Mesh data structure is created." << endl;
+
+    const double* XY = (const double*)(map + h.offset[cmeshXY]);
+    const int* conn = (const int*)(map + h.offset[cmeshConn]);
+    const int* FG = (const int*)(map + h.offset[cmeshFG]);
+
+    double scaleF = settings->getScale()/h.scale;
+    for(int i=0; i<nn; i++)
+    {
+        node[i].setX(scaleF==1.0 ? XY[2*i  ] : XY[2*i  ]*scaleF);
+        node[i].setY(scaleF==1.0 ? XY[2*i+1] : XY[2*i+1]*scaleF);
+    }
+    for(int i=0; i<ne; i++)
+        for(int j=0; j<nen; j++)
+        {
+            elem[i].setConn(j, conn[nen*i+j]);
+            elem[i].setFG(j, FG[nef*i+j]);
+        }
+
+    if (reordered)
+    {
+        origNode = new int [nn];
+        nodeIndex = new int [nn];
+        elemIndex = new int [ne];
+        memcpy(origNode, map + h.offset[cmeshOrigNode], nn*sizeof(int));
+        memcpy(elemIndex, map + h.offset[cmeshElemIndex], ne*sizeof(int));
+        for(int k=0; k<nn; k++)
+            nodeIndex[origNode[k]] = k;
+    }
+    unmapFile(map, mapSize);
+
+    readTime = wallTime() - readTime;
+    cout << "> Compiled mesh read: " << mapSize/1.0e6 << " MB in " << readTime << " s ("
+         << mapSize/1.0e6/readTime << " MB/s), numbering : " << h.reorder << endl;
+    if (reordered && settings->getReorder() != h.reorder)
+        cout << "> The numbering of the compiled mesh is kept, reorder " << settings->getReorder()
+             << " is not applied." << endl;
+
+    return;
+}
+
+//==================================================================================================
+// void triMesh::writeCompiledMesh()
+//==================================================================================================
+/* Writes the mesh as it is in memory (scaled and, if reordered, with the numbering maps) to a
+ * compiled mesh file, see cmeshHeader. The sections are padded with zeros to multiples of
+ * cmeshAlign bytes.
+ */
+//==================================================================================================
+void triMesh::writeCompiledMesh(string name, inputSettings* settings)
+{
+    cmeshHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "FEMCMESH", 8);
+    h.version = cmeshVersion;
+    h.byteOrder = 0x01020304;
+    h.ne = ne;
+    h.nn = nn;
+    h.scale = settings->getScale();
+    strncpy(h.reorder, (origNode==NULL ? "none" : settings->getReorder().c_str()), sizeof(h.reorder)-1);
+
+    ///Contiguous copies of the sections
+    double* XY = new double [nsd*nn];
+    int* conn = new int [nen*ne];
+    int* FG = new int [nef*ne];
+    for(int i=0; i<nn; i++)
+    {
+        XY[2*i  ] = node[i].getX();
+        XY[2*i+1] = node[i].getY();
+    }
+    for(int i=0; i<ne; i++)
+        for(int j=0; j<nen; j++)
+        {
+            conn[nen*i+j] = elem[i].getConn(j);
+            FG[nef*i+j] = elem[i].getFG(j);
+        }
+
+    const char* data[cmeshSections] = {(const char*)XY, (const char*)conn, (const char*)FG,
+                                       (const char*)origNode, (const char*)elemIndex};
+    long long bytes[cmeshSections] = {(long long)nn*nsd*(long long)sizeof(double),
+                                      (long long)ne*nen*(long long)sizeof(int),
+                                      (long long)ne*nef*(long long)sizeof(int),
+                                      (long long)nn*(long long)sizeof(int),
+                                      (long long)ne*(long long)sizeof(int)};
+
+    ///Offsets of the sections, each one starts at a multiple of cmeshAlign
+    long long pos = sizeof(h);
+    for(int s=0; s<cmeshSections; s++)
+    {
+        if (data[s] == NULL)
+            continue;
+        pos = (pos + cmeshAlign-1)/cmeshAlign*cmeshAlign;
+        h.offset[s] = pos;
+        h.bytes[s] = bytes[s];
+        pos += bytes[s];
+    }
+
+    ofstream file(name.c_str(), ios::out|ios::binary|ios::trunc);
+    if (file.is_open()==false)
+    {
+        cout << "Unable to open file : " << name << endl;
+        exit(0);
+    }
+    char pad[cmeshAlign] = {0};
+    file.write((const char*)&h, sizeof(h));
+    pos = sizeof(h);
+    for(int s=0; s<cmeshSections; s++)
+    {
+        if (h.offset[s] == 0)
+            continue;
+        file.write(pad, h.offset[s] - pos);
+        file.write(data[s], h.bytes[s]);
+        pos = h.offset[s] + h.bytes[s];
+    }
+    file.close();
+
+    ///A failed write (e.g. disk full) would leave a truncated file, which is removed
+    if (file.fail())
+    {
+        remove(name.c_str());
+        cout << "Unable to write file : " << name << ", the file is removed! Aborting..." << endl;
+        exit(0);
+    }
+
+    cout << "> Compiled mesh written: " << name << " (" << pos/1.0e6 << " MB, numbering : "
+         << h.reorder << ")" << endl;
+
+    delete[] XY;
+    delete[] conn;
+    delete[] FG;
+    return;
+}
+
+//==================================================================================================
+// const char* triMesh::mapFile()
+//==================================================================================================
+/* Maps a whole file read-only into memory and returns its first byte (NULL if the file can not be
+ * opened). MAP_POPULATE reads the file and fills the page table in the call, instead of one page
+ * fault per page during the decoding. A file shorter than minSize bytes does not hold the mesh
+ * given in minf.
+ */
+//==================================================================================================
+const char* triMesh::mapFile(string name, size_t minSize, size_t& size)
+{
+    size = 0;
+    int fd = open(name.c_str(), O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < minSize)
+    {
+        cout << "File " << name << " is shorter than " << minSize << " bytes! Aborting..." << endl;
+        exit(0);
+    }
+    size = st.st_size;
+
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        cout << "Unable to map file : " << name << "! Aborting..." << endl;
+        exit(0);
+    }
+
+    return (const char*)map;
+}
+
+//==================================================================================================
+// void triMesh::unmapFile()
+//==================================================================================================
+void triMesh::unmapFile(const char* map, size_t size)
+{
+    munmap((void*)map, size);
+
+    return;
+}
+
+
+/* File write procedure :
+ * Write data file so that it can be used for furthur processing 
+ * or as initial distribution file for next simulation
+ */
+void triMesh::writeDataFile(inputSettings* settings){
+    ofstream    file;           // file name obj
+    string      dummy;          // dummy string to hold names
+    char*       writeStream;    // temperory var used for strings write to files
+    double      dummyDouble;    // temperory var used for double values write to files
+
+    dummy = settings->getDataFile();
+    file.open(dummy.c_str(), ios::out|ios::binary|ios::ate);
+
+    if (file.is_open()==false){
+        cout << "Unable to open file : " << dummy << endl;
+	exit(0);
+    }
+
+    cout<<"> Writing temperature field distribution file."<<endl;
+    writeStream = new char [sizeof(double)];
+
+    for(int i=0; i<nn; i++){
+       	*((double*)writeStream) = node[getNodeIndex(i)].getT();
+       	swapBytes(writeStream, 1, sizeof(double));
+	file.write (writeStream, sizeof(double));
+    }
+	
+    cout << "> File write complete: " << dummy << endl;
+    file.close();
+
+return;
+}
+
+void triMesh::swapBytes (char *array, int nelem, int elsize)
+{
+    register int sizet, sizem, i, j;
+    char *bytea, *byteb;
+    sizet = elsize;
+    sizem = sizet - 1;
+    bytea = new char [sizet];
+    byteb = new char [sizet];
+    for (i = 0; i < nelem; i++)
+    {
+        memcpy((void *)bytea, (void *)(array+i*sizet), sizet);
+        for (j = 0; j < sizet; j++) 
+            byteb[j] = bytea[sizem - j];
+        memcpy((void *)(array+i*sizet), (void *)byteb, sizet);
+    }
+    free(bytea); 
+    free(byteb);
+
+    return;
+}
+
+
+//==================================================================================================
+// void triMesh::reorderMesh()
+//==================================================================================================
+/* Reordering procedure :
+ * 1- A new node order is computed, either by Reverse Cuthill-McKee on the node graph ("rcm") or by
+ *    sorting the nodes along a Hilbert curve through the bounding box ("hilbert"). Both place nodes
+ *    that share an element close to each other in memory.
+ * 2- Nodes are moved to their new position and the connectivity is renumbered.
+ * 3- Elements are sorted by their smallest node number, so the element loop walks through the
+ *    node arrays almost sequentially.
+ * The original numbers are kept in origNode/nodeIndex/elemIndex for output and restart files.
+ */
+//==================================================================================================
+void triMesh::reorderMesh(string method)
+{
+    int* order = new int [nn];
+    int bw = bandwidth();
+
+    if(method == "rcm")
+        rcmOrdering(order);
+    else if(method == "hilbert")
+        hilbertOrdering(order);
+    else
+    {
+        cout << "Unknown mesh reordering : " << method << "! Aborting..." << endl;
+        exit(0);
+    }
+
+    ///Move the nodes and renumber the connectivity
+    triNode* newNode = new triNode[nn];
+    nodeIndex = new int [nn];
+    for(int k=0; k<nn; k++)
+    {
+        newNode[k] = node[order[k]];
+        nodeIndex[order[k]] = k;
+    }
+    delete[] node;
+    node = newNode;
+    origNode = order;
+
+    for(int e=0; e<ne; e++)
+        for(int j=0; j<nen; j++)
+            elem[e].setConn(j, nodeIndex[elem[e].getConn(j)]);
+
+    ///Sort the elements by their smallest node
+    pair<int,int>* key = new pair<int,int> [ne];
+    for(int e=0; e<ne; e++)
+    {
+        int minNode = elem[e].getConn(0);
+        for(int j=1; j<nen; j++)
+            if(elem[e].getConn(j) < minNode)
+                minNode = elem[e].getConn(j);
+        key[e] = make_pair(minNode, e);
+    }
+    std::sort(key, key+ne);
+
+    triElement* newElem = new triElement[ne];
+    elemIndex = new int [ne];
+    for(int k=0; k<ne; k++)
+    {
+        newElem[k] = elem[key[k].second];
+        elemIndex[key[k].second] = k;
+    }
+    delete[] elem;
+    elem = newElem;
+
+    cout << "> Mesh is reordered (" << method << "), bandwidth : " << bw << " -> " << bandwidth()
+         << endl;
+
+    delete[] key;
+    return;
+}
+
+//==================================================================================================
+// void triMesh::buildNodeGraph()
+// Neighbours of every node (nodes sharing an element), stored in adj[adjPtr[i]..adjPtr[i+1]].
+//==================================================================================================
+void triMesh::buildNodeGraph(int*& adjPtr, int*& adj)
+{
+    int* fill = new int [nn]();
+    int* first = new int [nn+1];
+
+    ///Every element adds its two other nodes to each of its nodes, duplicates are removed below
+    for(int e=0; e<ne; e++)
+        for(int j=0; j<nen; j++)
+            fill[elem[e].getConn(j)] += nen-1;
+    first[0] = 0;
+    for(int i=0; i<nn; i++)
+    {
+        first[i+1] = first[i] + fill[i];
+        fill[i] = 0;
+    }
+
+    int* tmp = new int [first[nn]];
+    for(int e=0; e<ne; e++)
+        for(int j=0; j<nen; j++)
+            for(int k=0; k<nen; k++)
+                if(k != j)
+                {
+                    int i = elem[e].getConn(j);
+                    tmp[first[i] + fill[i]++] = elem[e].getConn(k);
+                }
+
+    adjPtr = new int [nn+1];
+    adjPtr[0] = 0;
+    for(int i=0; i<nn; i++)
+    {
+        std::sort(tmp+first[i], tmp+first[i+1]);
+        adjPtr[i+1] = adjPtr[i] + (std::unique(tmp+first[i], tmp+first[i+1]) - (tmp+first[i]));
+    }
+    adj = new int [adjPtr[nn]];
+    for(int i=0; i<nn; i++)
+        std::memcpy(adj+adjPtr[i], tmp+first[i], (adjPtr[i+1]-adjPtr[i])*sizeof(int));
+
+    delete[] fill;
+    delete[] first;
+    delete[] tmp;
+    return;
+}
+
+//==================================================================================================
+// void triMesh::rcmOrdering()
+//==================================================================================================
+/* Reverse Cuthill-McKee :
+ * 1- For every connected part of the mesh a start node is searched: beginning with the unnumbered
+ *    node of smallest degree, a breadth first search is repeated from a node of smallest degree in
+ *    the last level as long as the number of levels grows (pseudo-peripheral node).
+ * 2- Nodes are numbered level by level from the start node, the neighbours of each node in the
+ *    order of increasing degree.
+ * 3- The order is reversed. order[k] is the original number of the new node k.
+ */
+//==================================================================================================
+void triMesh::rcmOrdering(int* order)
+{
+    int *adjPtr, *adj;
+    buildNodeGraph(adjPtr, adj);
+
+    int* levelOf = new int [nn];
+    bool* numbered = new bool [nn];
+    pair<int,int>* nb = new pair<int,int> [nn];
+    for(int i=0; i<nn; i++)
+    {
+        numbered[i] = false;
+        levelOf[i] = -1;
+    }
+
+    ///Nodes by increasing degree, searched once from the front for the start nodes. Meshes with
+    ///many unconnected nodes have as many parts, so no step may visit all nodes for every part.
+    pair<int,int>* byDegree = new pair<int,int> [nn];
+    for(int i=0; i<nn; i++)
+        byDegree[i] = make_pair(adjPtr[i+1]-adjPtr[i], i);
+    std::sort(byDegree, byDegree+nn);
+    int next = 0;
+
+    int k = 0;
+    while(k < nn)
+    {
+        ///Unnumbered node of smallest degree
+        while(numbered[byDegree[next].second])
+            next++;
+        int root = byDegree[next].second;
+
+        ///Pseudo-peripheral node, the BFS queue is kept in order[k..]
+        int nLevels = 0;
+        for(int pass=0; pass<10; pass++)
+        {
+            int head = k, tail = k;
+            order[tail++] = root;
+            levelOf[root] = 0;
+            while(head < tail)
+            {
+                int i = order[head++];
+                for(int j=adjPtr[i]; j<adjPtr[i+1]; j++)
+                    if(!numbered[adj[j]] && levelOf[adj[j]] == -1)
+                    {
+                        levelOf[adj[j]] = levelOf[i] + 1;
+                        order[tail++] = adj[j];
+                    }
+            }
+            int last = order[tail-1];
+            int lastLevel = levelOf[last];
+            int peripheral = last;
+            for(int q=tail-1; q>=k && levelOf[order[q]] == lastLevel; q--)
+                if(adjPtr[order[q]+1]-adjPtr[order[q]] < adjPtr[peripheral+1]-adjPtr[peripheral])
+                    peripheral = order[q];
+
+            ///Only the nodes of this part were visited
+            for(int q=k; q<tail; q++)
+                levelOf[order[q]] = -1;
+
+            if(lastLevel + 1 <= nLevels)
+                break;
+            nLevels = lastLevel + 1;
+            root = peripheral;
+        }
+
+        ///Cuthill-McKee numbering from the start node
+        int head = k;
+        order[k++] = root;
+        numbered[root] = true;
+        while(head < k)
+        {
+            int i = order[head++];
+            int nNb = 0;
+            for(int j=adjPtr[i]; j<adjPtr[i+1]; j++)
+                if(!numbered[adj[j]])
+                {
+                    nb[nNb++] = make_pair(adjPtr[adj[j]+1]-adjPtr[adj[j]], adj[j]);
+                    numbered[adj[j]] = true;
+                }
+            std::sort(nb, nb+nNb);
+            for(int j=0; j<nNb; j++)
+                order[k++] = nb[j].second;
+        }
+    }
+
+    std::reverse(order, order+nn);
+
+    delete[] adjPtr;
+    delete[] adj;
+    delete[] levelOf;
+    delete[] numbered;
+    delete[] nb;
+    delete[] byDegree;
+    return;
+}
+
+//==================================================================================================
+// void triMesh::hilbertOrdering()
+//==================================================================================================
+/* Hilbert curve ordering :
+ * The bounding box of the mesh is divided into a 2^16 x 2^16 grid, every node gets the distance
+ * along the Hilbert curve of its grid cell as key and the nodes are sorted by this key. Nodes
+ * which belong to no element are put at the end.
+ * order[k] is the original number of the new node k.
+ */
+//==================================================================================================
+void triMesh::hilbertOrdering(int* order)
+{
+    const unsigned int n = 1 << 16;
+    double xMin = node[0].getX(), xMax = node[0].getX();
+    double yMin = node[0].getY(), yMax = node[0].getY();
+    for(int i=1; i<nn; i++)
+    {
+        xMin = min(xMin, node[i].getX());   xMax = max(xMax, node[i].getX());
+        yMin = min(yMin, node[i].getY());   yMax = max(yMax, node[i].getY());
+    }
+    double size = max(xMax-xMin, yMax-yMin);
+    if(size == 0.0)
+        size = 1.0;
+
+    pair<unsigned long long,int>* key = new pair<unsigned long long,int> [nn];
+    for(int i=0; i<nn; i++)
+    {
+        unsigned int x = (unsigned int)((node[i].getX()-xMin)/size*(n-1));
+        unsigned int y = (unsigned int)((node[i].getY()-yMin)/size*(n-1));
+        unsigned long long d = 0;
+
+        ///Distance along the curve, the quadrant is rotated at every level
+        for(unsigned int s=n/2; s>0; s/=2)
+        {
+            unsigned int rx = (x & s) > 0;
+            unsigned int ry = (y & s) > 0;
+            d += (unsigned long long)s*s*((3*rx)^ry);
+            if(ry == 0)
+            {
+                if(rx == 1)
+                {
+                    x = n-1-x;
+                    y = n-1-y;
+                }
+                unsigned int t = x;
+                x = y;
+                y = t;
+            }
+        }
+        key[i] = make_pair(d, i);
+    }
+
+    ///Nodes which belong to no element are moved behind all others
+    bool* used = new bool [nn]();
+    for(int e=0; e<ne; e++)
+        for(int j=0; j<nen; j++)
+            used[elem[e].getConn(j)] = true;
+    for(int i=0; i<nn; i++)
+        if(!used[i])
+            key[i].first = ~0ULL;
+    delete[] used;
+    std::sort(key, key+nn);
+
+    for(int k=0; k<nn; k++)
+        order[k] = key[k].second;
+
+    delete[] key;
+    return;
+}
+
+//==================================================================================================
+// int triMesh::bandwidth()
+// Largest difference of the node numbers within an element.
+//==================================================================================================
+int triMesh::bandwidth()
+{
+    int bw = 0;
+    for(int e=0; e<ne; e++)
+        for(int j=0; j<nen; j++)
+            for(int k=0; k<nen; k++)
+                bw = max(bw, elem[e].getConn(j) - elem[e].getConn(k));
+
+    return bw;
+}
+
+//==================================================================================================
+// void triMesh::allocElementData()
+// Allocates the data blocks of the element matrices (zero initialised) and hands one block to every
+// element. Nothing is done if they are allocated already.
+//==================================================================================================
+void triMesh::allocElementData()
+{
+    if(elemData != NULL)
+        return;
+
+    elemData = new double [(long long)ne*elemDataSize]();
+    for(int e=0; e<ne; e++)
+        elem[e].setData(elemData + (long long)e*elemDataSize);
+
+    return;
+}
+
+//==================================================================================================
+// void triMesh::freeElementData()
+// Releases the data blocks of the element matrices, e.g. for a solver which recomputes them from
+// the node coordinates. The matrices of the elements must not be used afterwards.
+//==================================================================================================
+void triMesh::freeElementData()
+{
+    for(int e=0; e<ne; e++)
+        elem[e].setData(NULL);
+    delete[] elemData;
+    elemData = NULL;
+
+    return;
+}
+
+//==================================================================================================
+// triMeshSoA
+//==================================================================================================
+triMeshSoA::triMeshSoA()
+{
+    ne = 0;
+    nn = 0;
+    for(int i=0; i<nen; i++)
+    {
+        conn[i] = NULL;
+        M[i] = NULL;
+        FB[i] = NULL;
+    }
+    for(int i=0; i<nen*nen; i++)
+    {
+        K[i] = NULL;
+        Kf[i] = NULL;
+    }
+    XY = NULL;
+    T = NULL;
+    BC_type = NULL;
+    nColours = 0;
+    colourPtr = NULL;
+    nLevels = 0;
+    level = NULL;
+    levelPtr = NULL;
+    nodeLevel = NULL;
+    levelNodes = NULL;
+    nodeLevelPtr = NULL;
+}
+
+triMeshSoA::~triMeshSoA()
+{
+    for(int i=0; i<nen; i++)
+    {
+        delete[] conn[i];
+        delete[] M[i];
+        delete[] FB[i];
+    }
+    for(int i=0; i<nen*nen; i++)
+    {
+        delete[] K[i];
+        delete[] Kf[i];
+    }
+    delete[] XY;
+    delete[] T;
+    delete[] BC_type;
+    delete[] colourPtr;
+    delete[] level;
+    delete[] levelPtr;
+    delete[] nodeLevel;
+    delete[] levelNodes;
+    delete[] nodeLevelPtr;
+}
+
+//==================================================================================================
+// void triMeshSoA::build()
+// Copies the element matrices and node values of the mesh into contiguous arrays. It has to be
+// called after the element matrices are calculated and the boundary conditions are applied.
+// Without matrices only the connectivity and the node coordinates are copied.
+//==================================================================================================
+void triMeshSoA::build(triMesh* mesh, bool withMatrices)
+{
+    ne = mesh->getNe();
+    nn = mesh->getNn();
+
+    for(int i=0; i<nen; i++)
+    {
+        conn[i] = new int [ne];
+        if(withMatrices)
+        {
+            M[i] = new double [ne];
+            FB[i] = new double [ne];
+        }
+    }
+    if(withMatrices)
+        for(int i=0; i<nen*nen; i++)
+            K[i] = new double [ne];
+    XY = new double [2*nn];
+    T = new double [nn];
+    BC_type = new int [nn];
+
+    triElement* elem;
+    for(int e=0; e<ne; e++)
+    {
+        elem = mesh->getElem(e);
+        for(int i=0; i<nen; i++)
+            conn[i][e] = elem->getConn(i);
+        if(!withMatrices)
+            continue;
+        for(int i=0; i<nen; i++)
+        {
+            M[i][e] = elem->getM()[i];
+            FB[i][e] = elem->getF()[i] + elem->getB()[i];
+        }
+        for(int i=0; i<nen*nen; i++)
+            K[i][e] = elem->getK()[i];
+    }
+
+    for(int i=0; i<nn; i++)
+    {
+        XY[2*i] = mesh->getNode(i)->getX();
+        XY[2*i+1] = mesh->getNode(i)->getY();
+    }
+    for(int i=0; i<nn; i++)
+        BC_type[i] = mesh->getNode(i)->getBC_type();
+    gatherT(mesh);
+
+    ///All elements belong to a single colour until colourElements() is called
+    nColours = 1;
+    colourPtr = new int [2];
+    colourPtr[0] = 0;
+    colourPtr[1] = ne;
+
+    ///and to a single time step level until groupLevels() is called
+    nLevels = 1;
+    level = new int [ne]();
+    levelPtr = new int [2];
+    levelPtr[0] = 0;
+    levelPtr[1] = 1;
+    nodeLevel = new int [nn]();
+    levelNodes = new int [nn];
+    for(int i=0; i<nn; i++)
+        levelNodes[i] = i;
+    nodeLevelPtr = new int [2];
+    nodeLevelPtr[0] = 0;
+    nodeLevelPtr[1] = nn;
+
+    return;
+}
+
+//==================================================================================================
+// void triMeshSoA::colourElements()
+//==================================================================================================
+/* Colouring procedure :
+ * 1- Colours are created one after the other. For the current colour the uncoloured elements are
+ *    visited in order, an element takes the colour if none of its nodes is already marked with it.
+ *    Its nodes are then marked, so no other element sharing a node can take the same colour.
+ * 2- This is repeated until every element has a colour.
+ * 3- The element arrays are sorted by level group and colour, colourPtr holds the start of every
+ *    colour and levelPtr the first colour of every level group.
+ */
+//==================================================================================================
+void triMeshSoA::colourElements()
+{
+    int* colour = new int [ne];
+    int* mark = new int [nn];
+    int nColoured = 0;
+    bool free;
+
+    for(int e=0; e<ne; e++)
+        colour[e] = -1;
+    for(int i=0; i<nn; i++)
+        mark[i] = -1;
+
+    nColours = 0;
+    while(nColoured < ne)
+    {
+        for(int e=0; e<ne; e++)
+        {
+            if(colour[e] != -1)
+                continue;
+
+            free = true;
+            for(int i=0; i<nen; i++)
+                if(mark[conn[i][e]] == nColours)
+                    free = false;
+            if(!free)
+                continue;
+
+            colour[e] = nColours;
+            for(int i=0; i<nen; i++)
+                mark[conn[i][e]] = nColours;
+            nColoured++;
+        }
+        nColours++;
+    }
+
+    ///Elements are sorted by the key (level group, colour), empty keys are dropped
+    int nKeys = nLevels*nColours;
+    int* key = new int [ne];
+    int* keyCount = new int [nKeys]();
+    for(int e=0; e<ne; e++)
+    {
+        key[e] = (nLevels-1-level[e])*nColours + colour[e];
+        keyCount[key[e]]++;
+    }
+    int nGlobal = nColours;
+
+    ///Start of each colour and level group and the new position of every element
+    delete[] colourPtr;
+    colourPtr = new int [nKeys+1];
+    colourPtr[0] = 0;
+    nColours = 0;
+    for(int k=0; k<nKeys; k++)
+    {
+        if(k%nGlobal == 0)
+            levelPtr[k/nGlobal] = nColours;
+        if(keyCount[k] == 0)
+            continue;
+        colourPtr[nColours+1] = colourPtr[nColours] + keyCount[k];
+        keyCount[k] = colourPtr[nColours];
+        nColours++;
+    }
+    levelPtr[nLevels] = nColours;
+
+    int* perm = new int [ne];
+    for(int e=0; e<ne; e++)
+        perm[keyCount[key[e]]++] = e;
+
+    permuteElements(perm);
+    cout << "> Elements are coloured with " << nGlobal << " colours." << endl;
+
+    delete[] colour;
+    delete[] mark;
+    delete[] key;
+    delete[] keyCount;
+    delete[] perm;
+    return;
+}
+
+//==================================================================================================
+// void triMeshSoA::groupLevels()
+//==================================================================================================
+/* Grouping for local time stepping, levels is the level of every node (its time step dt/2^level
+ * is stable) :
+ * 1- An element is evaluated whenever one of its nodes is updated, i.e. at the finest level of its
+ *    nodes.
+ * 2- Elements and nodes are sorted by level group (finest first), each level group is one colour
+ *    until colourElements() is called. It has to be called before colourElements().
+ */
+//==================================================================================================
+void triMeshSoA::groupLevels(int* levels)
+{
+    nLevels = 1;
+    for(int i=0; i<nn; i++)
+    {
+        nodeLevel[i] = levels[i];
+        if(levels[i]+1 > nLevels)
+            nLevels = levels[i]+1;
+    }
+
+    ///Evaluation level of the elements
+    for(int e=0; e<ne; e++)
+    {
+        level[e] = 0;
+        for(int i=0; i<nen; i++)
+            if(nodeLevel[conn[i][e]] > level[e])
+                level[e] = nodeLevel[conn[i][e]];
+    }
+
+    ///Sort the elements by level group, each group is one colour
+    delete[] colourPtr;
+    delete[] levelPtr;
+    colourPtr = new int [nLevels+1]();
+    levelPtr = new int [nLevels+1];
+    for(int e=0; e<ne; e++)
+        colourPtr[nLevels-level[e]]++;
+    for(int g=0; g<nLevels; g++)
+    {
+        colourPtr[g+1] += colourPtr[g];
+        levelPtr[g] = g;
+    }
+    levelPtr[nLevels] = nLevels;
+    nColours = nLevels;
+
+    int* count = new int [nLevels];
+    int* perm = new int [ne];
+    for(int g=0; g<nLevels; g++)
+        count[g] = colourPtr[g];
+    for(int e=0; e<ne; e++)
+        perm[count[nLevels-1-level[e]]++] = e;
+    permuteElements(perm);
+
+    ///Sort the nodes by level group
+    delete[] nodeLevelPtr;
+    nodeLevelPtr = new int [nLevels+1]();
+    for(int i=0; i<nn; i++)
+        nodeLevelPtr[nLevels-nodeLevel[i]]++;
+    for(int g=0; g<nLevels; g++)
+    {
+        nodeLevelPtr[g+1] += nodeLevelPtr[g];
+        count[g] = nodeLevelPtr[g];
+    }
+    for(int i=0; i<nn; i++)
+        levelNodes[count[nLevels-1-nodeLevel[i]]++] = i;
+
+    cout << "> Local time step levels (level: elements, nodes):" << endl;
+    for(int g=0; g<nLevels; g++)
+        cout << "  " << nLevels-1-g << ": " << colourPtr[g+1]-colourPtr[g] << ", "
+             << nodeLevelPtr[g+1]-nodeLevelPtr[g] << endl;
+
+    delete[] count;
+    delete[] perm;
+    return;
+}
+
+//==================================================================================================
+// void triMeshSoA::permuteElements()
+// Reorders all element arrays, the new element e is the old element perm[e].
+//==================================================================================================
+void triMeshSoA::permuteElements(int* perm)
+{
+    int* intTmp = new int [ne];
+    double* doubleTmp = new double [ne];
+
+    for(int i=0; i<nen; i++)
+    {
+        for(int e=0; e<ne; e++)
+            intTmp[e] = conn[i][perm[e]];
+        std::memcpy(conn[i], intTmp, ne*sizeof(int));
+
+        if(M[i] == NULL)
+            continue;
+
+        for(int e=0; e<ne; e++)
+            doubleTmp[e] = M[i][perm[e]];
+        std::memcpy(M[i], doubleTmp, ne*sizeof(double));
+
+        for(int e=0; e<ne; e++)
+            doubleTmp[e] = FB[i][perm[e]];
+        std::memcpy(FB[i], doubleTmp, ne*sizeof(double));
+    }
+    for(int i=0; i<nen*nen; i++)
+    {
+        if(K[i] != NULL)
+        {
+            for(int e=0; e<ne; e++)
+                doubleTmp[e] = K[i][perm[e]];
+            std::memcpy(K[i], doubleTmp, ne*sizeof(double));
+        }
+        if(Kf[i] != NULL)
+        {
+            for(int e=0; e<ne; e++)
+                doubleTmp[e] = Kf[i][perm[e]];
+            for(int e=0; e<ne; e++)
+                Kf[i][e] = doubleTmp[e];
+        }
+    }
+    for(int e=0; e<ne; e++)
+        intTmp[e] = level[perm[e]];
+    std::memcpy(level, intTmp, ne*sizeof(int));
+
+    delete[] intTmp;
+    delete[] doubleTmp;
+    return;
+}
+
+//==================================================================================================
+// void triMeshSoA::convertK()
+// Stores the element stiffness matrices in single precision. The double precision arrays are
+// released unless keepDouble is set.
+//==================================================================================================
+void triMeshSoA::convertK(bool keepDouble)
+{
+    for(int i=0; i<nen*nen; i++)
+    {
+        delete[] Kf[i];
+        Kf[i] = new float [ne];
+        for(int e=0; e<ne; e++)
+            Kf[i][e] = (float)K[i][e];
+
+        if(!keepDouble)
+        {
+            delete[] K[i];
+            K[i] = NULL;
+        }
+    }
+
+    return;
+}
+
+//==================================================================================================
+// void triMeshSoA::gatherT() / scatterT()
+// Copy the temperature field from the node objects to the contiguous array and vice versa.
+//==================================================================================================
+void triMeshSoA::gatherT(triMesh* mesh)
+{
+    for(int i=0; i<nn; i++)
+        T[i] = mesh->getNode(i)->getT();
+
+    return;
+}
+
+void triMeshSoA::scatterT(triMesh* mesh)
+{
+    for(int i=0; i<nn; i++)
+        mesh->getNode(i)->setT(T[i]);
+
+    return;
+}
+
+
+//==================================================================================================
+// GAUSS QUADRATURE POINTS AND WEIGHTS ARE SET FOR 7 POINT QUADRATURE FORMULA
+//==================================================================================================
+void triMasterElement::setupGaussQuadrature()
+{
+    this[0].point[0] = 0.333333333333333;   
+    this[0].point[1] = 0.333333333333333;
+    this[0].weight   = 0.225 / 2.0;
+    
+    this[1].point[0] = 0.059715871789770;   
+    this[1].point[1] = 0.470142064105115;
+    this[1].weight   = 0.132394152788 / 2.0;
+    
+    this[2].point[0] = 0.470142064105115;   
+    this[2].point[1] = 0.059715871789770;
+    this[2].weight   = 0.132394152788 / 2.0;
+    
+    this[3].point[0] = 0.470142064105115;   
+    this[3].point[1] = 0.470142064105115;
+    this[3].weight   = 0.132394152788 / 2.0;
+    
+    this[4].point[0] = 0.101286507323456;   
+    this[4].point[1] = 0.797426985353087;
+    this[4].weight   = 0.125939180544 / 2.0;
+    
+    this[5].point[0] = 0.101286507323456;   
+    this[5].point[1] = 0.101286507323456;
+    this[5].weight   = 0.125939180544 / 2.0;
+    
+    this[6].point[0] = 0.797426985353087;   
+    this[6].point[1] = 0.101286507323456;
+    this[6].weight   = 0.125939180544 / 2.0;
+
+    return;
+}
+
+//==================================================================================================
+// EVALUATES SHAPE FUNCTIONS FOR LINEAR TRIANGULAR ELEMENT
+//==================================================================================================
+void triMasterElement::evaluateShapeFunctions()
+{
+    double ksi;
+    double eta;
+    
+    for(int i=0; i<nGQP; i++)
+    {
+        ksi  = this[i].point[0];
+        eta  = this[i].point[1];
+
+        this[i].S[0] = 1.0-ksi-eta;
+        this[i].S[1] = ksi;
+        this[i].S[2] = eta;
+        
+        this[i].dSdKsi[0] = -1.0;
+        this[i].dSdKsi[1] =  1.0;
+        this[i].dSdKsi[2] =  0.0;
+
+        this[i].dSdEta[0] = -1.0;
+        this[i].dSdEta[1] =  0.0;
+        this[i].dSdEta[2] =  1.0;
+    }
+
+    return;
+}
+
+
@@ -92,6 +92,10 @@ class triNode
 };
 
 
+/// Layout of the data block of an element (offsets in doubles)
+enum elemDataEntry {elemJ = 0, elemJinv = 4, elemDetJ = 8, elemK = 9, elemM = 18, elemF = 21,
+                    elemB = 24, elemRHS = 27, elemDataSize = 30};
+
 /*!
  * \brief This class defines ELEMENT LEVEL DATA STRUCTURE.
  * 
@@ -99,6 +103,11 @@ class triNode
  * An element have a connectivity (the node numbers of the element) and face groups which indicates
  * which face has which boundary condition type. Other than these you will need to define element
  * mass stiffness matrices or any other matrices that will be necessary during the solution stage.
+ *
+ * The matrices (J, J_inv, |det J|, K, M, F, B, RHS) are kept in a block of elemDataSize doubles
+ * which belongs to the mesh (triMesh::allocElementData), so they can be freed when the solver does
+ * not need them any more (triMesh::freeElementData). The getters and setters of the matrices must
+ * only be used while the block is allocated.
  */
 class triElement
 {
@@ -106,21 +115,14 @@ class triElement
         /// PRIVATE VARIABLES
         int conn[nen];
         int FG[nef];
-	double J[4];
-	double J_inv[4];
-	double det_J_abs;
-	double K[9];
-	double M[3];
-	double F[3];
-	double B[3];
-	double RHS[3];
+	double* data;	// J, J_inv, |det J|, K, M, F, B, RHS (elemDataSize doubles, owned by the mesh)
         // and some more variables that you will need during the solution stage...
 
     protected:
 
     public:
         /// DEFAULT CONSTRUCTOR
-        triElement(){ B[0]=0.0f; B[1]=0.0f; B[2]=0.0f; };
+        triElement(){ data=NULL; };
 
         /// DESTRUCTOR
         ~triElement(){};
@@ -129,27 +131,64 @@ class triElement
 
         void setConn (int i, int value) {conn[i] = value;};
         void setFG   (int i, int value) {FG[i] = value;};
-        void setJ    (double* value) 	{std::memcpy(J,value,4*sizeof(double));};
-        void setJinv (double* value) 	{std::memcpy(J_inv,value,4*sizeof(double));};
-        void setDetJ (double value) 	{det_J_abs = value;};
-        void setK    (double* value) 	{std::memcpy(K,value,9*sizeof(double));};
-        void setM    (double* value) 	{std::memcpy(M,value,9*sizeof(double));};
-        void setF    (double* value) 	{std::memcpy(F,value,3*sizeof(double));};
-        void setB    (double* value) 	{std::memcpy(B,value,3*sizeof(double));};
-        void setRHS    (double* value) 	{std::memcpy(RHS,value,3*sizeof(double));};
+        void setData (double* value)	{data = value;};
+        void setJ    (double* value) 	{std::memcpy(data+elemJ,value,4*sizeof(double));};
+        void setJinv (double* value) 	{std::memcpy(data+elemJinv,value,4*sizeof(double));};
+        void setDetJ (double value) 	{data[elemDetJ] = value;};
+        void setK    (double* value) 	{std::memcpy(data+elemK,value,9*sizeof(double));};
+        void setM    (double* value) 	{std::memcpy(data+elemM,value,3*sizeof(double));};
+        void setF    (double* value) 	{std::memcpy(data+elemF,value,3*sizeof(double));};
+        void setB    (double* value) 	{std::memcpy(data+elemB,value,3*sizeof(double));};
+        void setRHS    (double* value) 	{std::memcpy(data+elemRHS,value,3*sizeof(double));};
 
         /// GETTERS
 
         int  getConn (int index) {return conn[index];};
         int  getFG   (int index) {return FG[index];}
-        double* getJ () 	 {return J;};
-        double* getJinv () 	 {return J_inv;};
-        double getDetJ () 	 {return det_J_abs;};
-        double* getK ()		 {return K;};
-        double* getM ()		 {return M;};
-        double* getF ()		 {return F;};
-        double* getB ()		 {return B;};
-        double* getRHS ()	 {return RHS;};
+        double* getJ () 	 {return data+elemJ;};
+        double* getJinv () 	 {return data+elemJinv;};
+        double getDetJ () 	 {return data[elemDetJ];};
+        double* getK ()		 {return data+elemK;};
+        double* getM ()		 {return data+elemM;};
+        double* getF ()		 {return data+elemF;};
+        double* getB ()		 {return data+elemB;};
+        double* getRHS ()	 {return data+elemRHS;};
+};
+
+
+/// Sections of a compiled mesh file
+enum cmeshSection {cmeshXY, cmeshConn, cmeshFG, cmeshOrigNode, cmeshElemIndex, cmeshSections};
+
+const int cmeshVersion = 1;     /// version of the compiled mesh format
+const int cmeshAlign = 64;      /// alignment (bytes) of the sections of a compiled mesh file
+
+/*!
+ * \brief This struct defines the HEADER OF A COMPILED MESH FILE.
+ *
+ * A compiled mesh (.cmesh) holds the mesh in the native byte order of the machine that wrote it,
+ * so it is used without decoding. The header is followed by the sections, each starting at a
+ * multiple of cmeshAlign bytes:
+ *	cmeshXY		x and y of each node (double, 2*nn, scaled)
+ *	cmeshConn	connectivity (int, 3*ne, zero based)
+ *	cmeshFG		face groups (int, 3*ne)
+ *	cmeshOrigNode	original number of each node (int, nn), only if the mesh is reordered
+ *	cmeshElemIndex	current number of each original element (int, ne), only if reordered
+ * Sections that are not present have offset 0.
+ * Element matrices are not stored, they depend on D, the kernel and the BCs of a run. Partition
+ * maps (mprm/nprm) are not stored either, the shared memory solver has no use for them; new
+ * sections would come with a new cmeshVersion.
+ */
+struct cmeshHeader
+{
+    char        magic[8];                   // "FEMCMESH"
+    int         version;                    // cmeshVersion
+    int         byteOrder;                  // 0x01020304 in the byte order of the writer
+    int         ne;                         // number of elements
+    int         nn;                         // number of nodes
+    double      scale;                      // scaling factor applied to the coordinates
+    char        reorder[16];                // ordering of the stored mesh (none/rcm/hilbert)
+    long long   offset[cmeshSections];      // first byte of each section
+    long long   bytes[cmeshSections];       // size of each section
 };
 
 
@@ -169,15 +208,27 @@ class triMesh
         triNode*            node;   // pointer for node level data structure
         triElement*         elem;   // pointer for element level data structure
         triMasterElement*   ME;     // pointer for reference element
+        int*    origNode;           // original number of each node (NULL if not reordered)
+        int*    nodeIndex;          // current number of each original node
+        int*    elemIndex;          // current number of each original element
+        double* elemData;           // data blocks of all elements (NULL if not allocated)
 
         /// PRIVATE METHODS
         void swapBytes(char*, int, int);
+        const char* mapFile(string, size_t, size_t&);
+        void unmapFile(const char*, size_t);
+        void readCompiledMesh(inputSettings*);
+        void readDataFile(inputSettings*);
+        void buildNodeGraph(int*&, int*&);
+        void rcmOrdering(int*);
+        void hilbertOrdering(int*);
+        int  bandwidth();
         
     protected:
 
     public:
         /// DEFAULT CONSTRUCTOR
-        triMesh(){};
+        triMesh(){origNode=NULL; nodeIndex=NULL; elemIndex=NULL; elemData=NULL;};
 
         /// DESTRUCTOR       
         ~triMesh()
@@ -185,6 +236,10 @@ class triMesh
             delete[] node;
             delete[] elem;
             delete[] ME;
+            delete[] origNode;
+            delete[] nodeIndex;
+            delete[] elemIndex;
+            delete[] elemData;
         };
 
         /// GETTERS
@@ -195,9 +250,109 @@ class triMesh
         triElement*         getElem (int index) {return &elem[index];};
         triMasterElement*   getME   (int index) {return &ME[index];};
 
+        /// Mapping between the original numbering of the mesh files and the reordered mesh. Output
+        /// and restart files are written in the original numbering.
+        int getOrigNode (int i) {return (origNode==NULL ? i : origNode[i]);};
+        int getNodeIndex(int i) {return (nodeIndex==NULL ? i : nodeIndex[i]);};
+        int getElemIndex(int e) {return (elemIndex==NULL ? e : elemIndex[e]);};
+
         /// PUBLIC INTERFACE METHOD
         void readMeshFiles(inputSettings*);
+        void readBinaryFiles(inputSettings*);
+        void writeCompiledMesh(string, inputSettings*);
         void writeDataFile(inputSettings*);
+        void reorderMesh(string);
+        void allocElementData();
+        void freeElementData();
+};
+
+
+/*!
+ * \brief This class defines a STRUCTURE-OF-ARRAYS COPY OF THE MESH for the time loop.
+ *
+ * triElement and triNode keep everything that is computed during the setup in one object per
+ * element or node. The time loop needs only a few of those values, so after the setup they are
+ * copied into separate contiguous arrays: the connectivity as conn[0..2][e], every entry of the
+ * element stiffness matrix as K[0..8][e], the lumped mass as M[0..2][e], the source and boundary
+ * vector F + B as FB[0..2][e] and the temperature of all nodes in T[].
+ *
+ * For the matrix-free solver only the connectivity and the node coordinates XY[] (x and y of a
+ * node next to each other) are needed, the element arrays K, M and FB are then not allocated
+ * (build(mesh, false)).
+ *
+ * For the mixed precision solver K can be converted to single precision (Kf), the overloaded
+ * getK(i, k) returns the array of the precision of k.
+ *
+ * For the threaded solver the elements can be coloured such that no two elements of the same
+ * colour share a node. The element arrays are then sorted by colour and the elements of one colour
+ * (colourPtr[c] to colourPtr[c+1]) can scatter into the node arrays in parallel without races.
+ *
+ * For local time stepping the elements are grouped by time step level, finest level first, so
+ * the elements that are evaluated in a sub-step are always the first groups. Level group g holds
+ * the colours levelPtr[g] to levelPtr[g+1]. Without levels there is a single group.
+ */
+class triMeshSoA
+{
+    private:
+        /// PRIVATE VARIABLES
+        int ne;                     // total number of elements
+        int nn;                     // number of nodes
+        int*    conn[nen];          // connectivity, one array per local node
+        double* K[nen*nen];         // element stiffness matrix, one array per entry
+        float*  Kf[nen*nen];        // single precision copy of K (see convertK)
+        double* M[nen];             // lumped element mass matrix, one array per local node
+        double* FB[nen];            // element source and boundary vector F + B
+        double* XY;                 // coordinates of the nodes (x at 2i, y at 2i+1)
+        double* T;                  // temperature of the nodes
+        int*    BC_type;            // boundary type of the nodes
+        int     nColours;           // number of element colours
+        int*    colourPtr;          // first element of each colour (size nColours+1)
+        int     nLevels;            // number of local time step levels
+        int*    level;              // time step level at which each element is evaluated
+        int*    levelPtr;           // first colour of each level group (size nLevels+1)
+        int*    nodeLevel;          // time step level of each node
+        int*    levelNodes;         // nodes sorted by level group
+        int*    nodeLevelPtr;       // first node of each level group in levelNodes
+
+        /// PRIVATE METHODS
+        void permuteElements(int*);
+
+    protected:
+
+    public:
+        /// DEFAULT CONSTRUCTOR
+        triMeshSoA();
+
+        /// DESTRUCTOR
+        ~triMeshSoA();
+
+        /// GETTERS
+        int     getNe()             {return ne;};
+        int     getNn()             {return nn;};
+        int*    getConn (int i)     {return conn[i];};
+        double* getK    (int i)     {return K[i];};
+        void    getK    (int i, double*& k) {k = K[i];};
+        void    getK    (int i, float*& k)  {k = Kf[i];};
+        double* getM    (int i)     {return M[i];};
+        double* getFB   (int i)     {return FB[i];};
+        double* getXY   ()          {return XY;};
+        double* getT    ()          {return T;};
+        int*    getBC_type ()       {return BC_type;};
+        int     getNColours()       {return nColours;};
+        int*    getColourPtr()      {return colourPtr;};
+        int     getNLevels()        {return nLevels;};
+        int*    getLevelPtr()       {return levelPtr;};
+        int*    getNodeLevel()      {return nodeLevel;};
+        int*    getLevelNodes()     {return levelNodes;};
+        int*    getNodeLevelPtr()   {return nodeLevelPtr;};
+
+        /// PUBLIC INTERFACE METHODS
+        void build(triMesh*, bool withMatrices = true);
+        void gatherT(triMesh*);
+        void scatterT(triMesh*);
+        void colourElements();
+        void groupLevels(int*);
+        void convertK(bool);
 };
 
 